@@ -0,0 +1,71 @@
+#shader vertex
+#version 330 core
+
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoords;
+
+out vec2 vTexCoords;
+
+void main()
+{
+    gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0); 
+    vTexCoords = aTexCoords;
+}
+
+
+#shader fragment
+#version 330 core
+
+out vec4 FragColor;
+
+
+in vec2 vTexCoords;
+
+// layers in draw order, first one is at the bottom
+uniform sampler2D uLayers[8];
+uniform float uOpacity[8];
+uniform int uBlendMode[8];
+uniform int uLayerCount;
+
+// glsl 330 only allows constant sampler array indices
+vec4 SampleLayer(int index, vec2 uv)
+{
+    switch(index)
+    {
+        case 0: return texture(uLayers[0], uv);
+        case 1: return texture(uLayers[1], uv);
+        case 2: return texture(uLayers[2], uv);
+        case 3: return texture(uLayers[3], uv);
+        case 4: return texture(uLayers[4], uv);
+        case 5: return texture(uLayers[5], uv);
+        case 6: return texture(uLayers[6], uv);
+        case 7: return texture(uLayers[7], uv);
+    }
+    return vec4(0.0);
+}
+
+void main()
+{
+    // same result as drawing layers one by one with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA blending
+    vec4 color = vec4(0.0);
+    for(int i = 0; i < uLayerCount; i++)
+    {
+        vec4 layer = SampleLayer(i, vTexCoords);
+        if(layer.a < 0.1) // fullscreen.glsl discards these
+            continue;
+        float alpha = layer.a * uOpacity[i];
+
+        vec3 blended = layer.rgb;
+        if(uBlendMode[i] == 1) // additive
+            blended = color.rgb + layer.rgb;
+        else if(uBlendMode[i] == 2) // multiply
+            blended = color.rgb * layer.rgb;
+        else if(uBlendMode[i] == 3) // screen
+            blended = 1.0 - (1.0 - color.rgb) * (1.0 - layer.rgb);
+
+        color.rgb = mix(color.rgb, blended, alpha);
+        color.a = alpha * alpha + color.a * (1.0 - alpha);
+    }
+
+    FragColor = color;
+}
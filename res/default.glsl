@@ -4,24 +4,32 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+// per instance, used when uInstanced != 0
+layout (location = 3) in mat4 aInstanceModel; // 3-6
+layout (location = 7) in int aInstanceDrawID;
 
 uniform mat4 uModel;
 uniform mat4 uViewProjection;
+uniform int uDrawID;
+uniform int uInstanced;
 
 
 out vec2 vTexCoords;
 out vec3 vNormal;
 out vec3 vModelPos;
+flat out int vDrawID;
 
 void main()
 {
-    vModelPos = vec3(uModel * vec4(aPos, 1.0f));
+    mat4 model = uInstanced != 0 ? aInstanceModel : uModel;
+    vModelPos = vec3(model * vec4(aPos, 1.0f));
 
-    gl_Position = uViewProjection * uModel * vec4(aPos.x, aPos.y, aPos.z, 1.0);
+    gl_Position = uViewProjection * model * vec4(aPos.x, aPos.y, aPos.z, 1.0);
     
 
     vTexCoords = aTexCoords;
     vNormal = aNormal;
+    vDrawID = uInstanced != 0 ? aInstanceDrawID : uDrawID;
 }
 
 
@@ -37,9 +45,9 @@ layout(location = 3) out int gDrawID;
 in vec2 vTexCoords;
 in vec3 vNormal;
 in vec3 vModelPos;
+flat in int vDrawID;
 
 
-uniform int uDrawID;
 // Material
 uniform vec4 uMat_Albedo;
 uniform sampler2D uMat_AlbedoTex;
@@ -57,5 +65,5 @@ void main()
 	gPosition = vec4(vModelPos, 1.0);
 	gNormal = vec4(normalize(vNormal), 1.0);
 
-	gDrawID = uDrawID;
+	gDrawID = vDrawID;
 }
\ No newline at end of file
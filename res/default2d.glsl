@@ -1,18 +1,27 @@
 #shader vertex
 #version 330 core
 
-layout (location = 0) in vec2 aPos;
+layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec4 aTint;
+layout (location = 3) in int aTexIndex;
+layout (location = 4) in int aDrawID;
 
-uniform mat4 uModel;
 uniform mat4 uViewProjection;
 
 out vec2 vTexCoords;
+out vec4 vTint;
+flat out int vTexIndex;
+flat out int vDrawID;
 
 void main()
 {
-    gl_Position = uViewProjection * uModel * vec4(aPos.x, aPos.y, 0.0, 1.0);
+    // aPos is already in world space, sprites are transformed on batching
+    gl_Position = uViewProjection * vec4(aPos, 1.0);
     vTexCoords = aTexCoords;
+    vTint = aTint;
+    vTexIndex = aTexIndex;
+    vDrawID = aDrawID;
 }
 
 
@@ -24,16 +33,42 @@ layout(location = 1) out int gDrawID;
 
 
 in vec2 vTexCoords;
+in vec4 vTint;
+flat in int vTexIndex;
+flat in int vDrawID;
 
-uniform sampler2D uTexture;
-uniform vec4 uTint;
-uniform int uDrawID;
+uniform sampler2D uTextures[16];
+
+// glsl 330 only allows constant sampler array indices
+vec4 SampleTexture(int index, vec2 uv)
+{
+    switch(index)
+    {
+        case 0:  return texture(uTextures[0], uv);
+        case 1:  return texture(uTextures[1], uv);
+        case 2:  return texture(uTextures[2], uv);
+        case 3:  return texture(uTextures[3], uv);
+        case 4:  return texture(uTextures[4], uv);
+        case 5:  return texture(uTextures[5], uv);
+        case 6:  return texture(uTextures[6], uv);
+        case 7:  return texture(uTextures[7], uv);
+        case 8:  return texture(uTextures[8], uv);
+        case 9:  return texture(uTextures[9], uv);
+        case 10: return texture(uTextures[10], uv);
+        case 11: return texture(uTextures[11], uv);
+        case 12: return texture(uTextures[12], uv);
+        case 13: return texture(uTextures[13], uv);
+        case 14: return texture(uTextures[14], uv);
+        case 15: return texture(uTextures[15], uv);
+    }
+    return vec4(1.0);
+}
 
 void main()
 {
-	gAlbedo = texture(uTexture, vTexCoords) * uTint;
-	gDrawID = uDrawID;
+	gAlbedo = SampleTexture(vTexIndex, vTexCoords) * vTint;
+	gDrawID = vDrawID;
 
     if(gAlbedo.a < 0.1)
         discard;
-}
\ No newline at end of file
+}
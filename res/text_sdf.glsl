@@ -0,0 +1,32 @@
+#shader vertex
+
+#version 330 core
+layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+out vec2 TexCoords;
+
+uniform mat4 projection;
+uniform mat4 model;
+
+void main()
+{
+    gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
+    TexCoords = vertex.zw;
+}
+
+#shader fragment
+
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2D text;
+uniform vec3 textColor;
+
+void main()
+{
+    // freetype sdf: 0.5 is on the outline, larger values are inside
+    float distance = texture(text, TexCoords).r;
+    float width = fwidth(distance);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    color = vec4(textColor, alpha);
+}
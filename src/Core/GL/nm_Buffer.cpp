@@ -1,5 +1,6 @@
 #include "nm_Buffer.hpp"
 #include "glad/glad.h"
+#include "nm_StateCache.hpp"
 
 namespace nmGfx
 {
@@ -23,12 +24,12 @@ namespace nmGfx
 
     void Buffer::Use()
     {
-        glBindBuffer(GetBufferType(_type), _bufferID);
+        StateCache::Get().BindBuffer(GetBufferType(_type), _bufferID);
     }
 
     void Buffer::Unbind()
     {
-        glBindBuffer(GetBufferType(_type), 0);
+        StateCache::Get().BindBuffer(GetBufferType(_type), 0);
     }
 
     Buffer::~Buffer()
@@ -48,7 +49,10 @@ namespace nmGfx
     void Buffer::Delete()
     {
         if(_bufferID != 0)
+        {
+            StateCache::Get().OnBufferDeleted(_bufferID);
             glDeleteBuffers(1, &_bufferID);
+        }
         
         _bufferID = 0;
     }
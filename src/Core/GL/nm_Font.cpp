@@ -1,13 +1,386 @@
 #include "nm_Font.hpp"
+#include <stdio.h>
 
 #include "glad/glad.h"
-#include "stb_image.h"
+#include "nm_StateCache.hpp"
+
+#include "ft2build.h"
+#include FT_FREETYPE_H
 
 
 namespace nmGfx
 {
+    Font::GlyphTable::GlyphTable()
+    {
+        Clear();
+    }
+
+    void Font::GlyphTable::Clear()
+    {
+        for(uint32_t i = 0; i < DENSE_SIZE; i++)
+            _denseUsed[i] = false;
+        _slots.clear();
+        _used = 0;
+    }
+
+    const Font::Character* Font::GlyphTable::FindHashed(uint32_t codepoint) const
+    {
+        if(_slots.empty())
+            return nullptr;
+
+        size_t mask = _slots.size() - 1;
+        for(size_t i = Hash(codepoint) & mask;; i = (i + 1) & mask)
+        {
+            const Slot& slot = _slots[i];
+            if(slot.codepoint == codepoint)
+                return &slot.character;
+            if(slot.codepoint == EMPTY)
+                return nullptr;
+        }
+    }
+
+    void Font::GlyphTable::Rehash(size_t capacity)
+    {
+        std::vector<Slot> old;
+        old.swap(_slots);
+        _slots.assign(capacity, Slot{ EMPTY, Character{} });
+        _used = 0;
+
+        size_t mask = capacity - 1;
+        for(const Slot& slot : old)
+        {
+            if(slot.codepoint == EMPTY || slot.codepoint == TOMBSTONE)
+                continue;
+            size_t i = Hash(slot.codepoint) & mask;
+            while(_slots[i].codepoint != EMPTY)
+                i = (i + 1) & mask;
+            _slots[i] = slot;
+            _used++;
+        }
+    }
+
+    Font::Character& Font::GlyphTable::Insert(uint32_t codepoint, const Character& character)
+    {
+        if(codepoint < DENSE_SIZE)
+        {
+            _denseUsed[codepoint] = true;
+            _dense[codepoint] = character;
+            return _dense[codepoint];
+        }
+
+        // keep load factor under 0.75, tombstones count as used
+        if((_used + 1) * 4 > _slots.size() * 3)
+            Rehash(_slots.empty() ? 64 : _slots.size() * 2);
+
+        size_t mask = _slots.size() - 1;
+        size_t tombstone = _slots.size();
+        size_t i = Hash(codepoint) & mask;
+        for(;; i = (i + 1) & mask)
+        {
+            Slot& slot = _slots[i];
+            if(slot.codepoint == codepoint)
+            {
+                slot.character = character;
+                return slot.character;
+            }
+            if(slot.codepoint == TOMBSTONE && tombstone == _slots.size())
+                tombstone = i;
+            if(slot.codepoint == EMPTY)
+                break;
+        }
+
+        if(tombstone != _slots.size())
+            i = tombstone;
+        else
+            _used++;
+        _slots[i] = Slot{ codepoint, character };
+        return _slots[i].character;
+    }
+
+    void Font::GlyphTable::Erase(uint32_t codepoint)
+    {
+        if(codepoint < DENSE_SIZE)
+        {
+            _denseUsed[codepoint] = false;
+            return;
+        }
+        if(_slots.empty())
+            return;
+
+        size_t mask = _slots.size() - 1;
+        for(size_t i = Hash(codepoint) & mask;; i = (i + 1) & mask)
+        {
+            if(_slots[i].codepoint == codepoint)
+            {
+                _slots[i].codepoint = TOMBSTONE;
+                return;
+            }
+            if(_slots[i].codepoint == EMPTY)
+                return;
+        }
+    }
+
+
+    static uint64_t s_NextFontId = 1;
+
+    Font::Font()
+        : _Id(s_NextFontId++)
+    {
+    }
+
     Font::~Font()
     {
-        
+        Clear();
+    }
+
+    void Font::Clear()
+    {
+        for(auto& page : _Pages)
+        {
+            StateCache::Get().OnTextureDeleted(page.TextureID);
+            glDeleteTextures(1, &page.TextureID);
+        }
+        _Pages.clear();
+        _Characters.Clear();
+        _AtlasGeneration++;
+
+        if(_Face != nullptr)
+            FT_Done_Face(_Face);
+        _Face = nullptr;
+        _FaceData.clear();
+    }
+
+    uint32_t Font::NextCodepoint(std::string::const_iterator& it, std::string::const_iterator end)
+    {
+        static const uint32_t REPLACEMENT = 0xFFFD;
+
+        unsigned char lead = (unsigned char)*it++;
+        if(lead < 0x80)
+            return lead;
+
+        int length = (lead & 0xE0) == 0xC0 ? 2
+                   : (lead & 0xF0) == 0xE0 ? 3
+                   : (lead & 0xF8) == 0xF0 ? 4
+                   : 0;
+        if(length == 0)
+            return REPLACEMENT;
+
+        uint32_t codepoint = lead & (0xFF >> (length + 1));
+        std::string::const_iterator next = it;
+        for(int i = 1; i < length; i++)
+        {
+            if(next == end || ((unsigned char)*next & 0xC0) != 0x80)
+                return REPLACEMENT;
+            codepoint = (codepoint << 6) | ((unsigned char)*next & 0x3F);
+            next++;
+        }
+
+        // overlong encodings, surrogates and out of range values
+        static const uint32_t minimum[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+        if(codepoint < minimum[length] || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+            return REPLACEMENT;
+
+        it = next;
+        return codepoint;
+    }
+
+    const Font::Character* Font::GetCharacter(uint32_t codepoint)
+    {
+        const Character* ch = _Characters.Find(codepoint);
+        if(ch == nullptr)
+        {
+            if(!LoadGlyph(codepoint))
+                return nullptr;
+            ch = _Characters.Find(codepoint);
+        }
+
+        if(ch->Page >= 0)
+            _Pages[ch->Page].Shelves[ch->Shelf].lastUsed = _UseTick;
+        return ch;
+    }
+
+    bool Font::LoadGlyph(uint32_t codepoint)
+    {
+        if(_Face == nullptr)
+            return false;
+
+        if(_RenderMode == FontRenderMode::SDF)
+        {
+            if(FT_Load_Char(_Face, codepoint, FT_LOAD_DEFAULT))
+                return false;
+            // glyphs without outline (whitespace) fail to render, keep their metrics
+            if(FT_Render_Glyph(_Face->glyph, FT_RENDER_MODE_SDF))
+            {
+                return AddGlyph(
+                    codepoint, nullptr, 0, 0,
+                    glm::ivec2(_Face->glyph->bitmap_left, _Face->glyph->bitmap_top),
+                    static_cast<unsigned int>(_Face->glyph->advance.x)
+                );
+            }
+        }
+        else if(FT_Load_Char(_Face, codepoint, FT_LOAD_RENDER))
+        {
+            return false;
+        }
+
+        return AddGlyph(
+            codepoint,
+            _Face->glyph->bitmap.buffer,
+            _Face->glyph->bitmap.width,
+            _Face->glyph->bitmap.rows,
+            glm::ivec2(_Face->glyph->bitmap_left, _Face->glyph->bitmap_top),
+            static_cast<unsigned int>(_Face->glyph->advance.x)
+        );
+    }
+
+    void Font::AddPage()
+    {
+        AtlasPage page;
+
+        // zeroed so padding between glyphs is transparent
+        std::vector<unsigned char> empty(ATLAS_SIZE * ATLAS_SIZE, 0);
+
+        glGenTextures(1, &page.TextureID);
+        StateCache::Get().BindTexture(GL_TEXTURE_2D, page.TextureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_SIZE, ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        _Pages.push_back(page);
+    }
+
+    bool Font::EvictShelf(int height)
+    {
+        // least recently used shelf tall enough, glyphs used since BeginUse() are kept
+        int bestPage = -1;
+        int bestShelf = -1;
+        for(size_t p = 0; p < _Pages.size(); p++)
+        {
+            for(size_t s = 0; s < _Pages[p].Shelves.size(); s++)
+            {
+                const AtlasPage::Shelf& shelf = _Pages[p].Shelves[s];
+                if(shelf.height < height || shelf.lastUsed == _UseTick || shelf.glyphs.empty())
+                    continue;
+                if(bestPage < 0 || shelf.lastUsed < _Pages[bestPage].Shelves[bestShelf].lastUsed)
+                {
+                    bestPage = (int)p;
+                    bestShelf = (int)s;
+                }
+            }
+        }
+        if(bestPage < 0)
+            return false;
+
+        AtlasPage::Shelf& shelf = _Pages[bestPage].Shelves[bestShelf];
+        for(uint32_t codepoint : shelf.glyphs)
+            _Characters.Erase(codepoint);
+        shelf.glyphs.clear();
+        shelf.x = 0;
+        _AtlasGeneration++;
+
+        // clear old pixels so they don't bleed into padding of new glyphs
+        std::vector<unsigned char> empty(ATLAS_SIZE * shelf.height, 0);
+        StateCache::Get().BindTexture(GL_TEXTURE_2D, _Pages[bestPage].TextureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, shelf.y, ATLAS_SIZE, shelf.height, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+
+#ifdef NMGFX_PRINT_MESSAGES
+        printf("Font atlas full, evicted shelf %i of page %i\n", bestShelf, bestPage);
+#endif
+        return true;
+    }
+
+    bool Font::PackRect(int width, int height, int& page, int& shelf, glm::ivec2& position)
+    {
+        int paddedWidth = width + GLYPH_PADDING * 2;
+        int paddedHeight = height + GLYPH_PADDING * 2;
+        if(paddedWidth > ATLAS_SIZE || paddedHeight > ATLAS_SIZE)
+            return false;
+
+        for(size_t p = 0; p < _Pages.size(); p++)
+        {
+            AtlasPage& atlas = _Pages[p];
+
+            // best fitting existing shelf
+            int best = -1;
+            for(size_t s = 0; s < atlas.Shelves.size(); s++)
+            {
+                const AtlasPage::Shelf& candidate = atlas.Shelves[s];
+                if(candidate.height >= paddedHeight && candidate.x + paddedWidth <= ATLAS_SIZE)
+                {
+                    if(best < 0 || candidate.height < atlas.Shelves[best].height)
+                        best = (int)s;
+                }
+            }
+
+            // open a new shelf under the last one
+            if(best < 0 && atlas.ShelfBottom + paddedHeight <= ATLAS_SIZE)
+            {
+                atlas.Shelves.push_back(AtlasPage::Shelf{ atlas.ShelfBottom, paddedHeight, 0, 0, {} });
+                atlas.ShelfBottom += paddedHeight;
+                best = (int)atlas.Shelves.size() - 1;
+            }
+
+            if(best >= 0)
+            {
+                AtlasPage::Shelf& target = atlas.Shelves[best];
+                page = (int)p;
+                shelf = best;
+                position = glm::ivec2(target.x + GLYPH_PADDING, target.y + GLYPH_PADDING);
+                target.x += paddedWidth;
+                return true;
+            }
+        }
+
+        if((int)_Pages.size() < _MaxPages)
+            AddPage();
+        else if(!EvictShelf(paddedHeight))
+            return false;
+
+        return PackRect(width, height, page, shelf, position);
+    }
+
+    bool Font::AddGlyph(uint32_t codepoint, const unsigned char* bitmap, int width, int height, glm::ivec2 bearing, unsigned int advance)
+    {
+        Character character{};
+        character.Page = -1;
+        character.Shelf = -1;
+        character.Size = glm::ivec2(width, height);
+        character.Bearing = bearing;
+        character.Advance = advance;
+
+        // whitespace has no bitmap, only metrics
+        if(width > 0 && height > 0)
+        {
+            int page = 0;
+            int shelf = 0;
+            glm::ivec2 position;
+            if(!PackRect(width, height, page, shelf, position))
+            {
+#ifdef NMGFX_PRINT_MESSAGES
+                printf("Glyph %u (%ix%i) doesn't fit in font atlas\n", codepoint, width, height);
+#endif
+                return false;
+            }
+
+            StateCache::Get().BindTexture(GL_TEXTURE_2D, _Pages[page].TextureID);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, position.x, position.y, width, height, GL_RED, GL_UNSIGNED_BYTE, bitmap);
+
+            AtlasPage::Shelf& target = _Pages[page].Shelves[shelf];
+            target.glyphs.push_back(codepoint);
+            target.lastUsed = _UseTick;
+
+            character.Page = page;
+            character.Shelf = shelf;
+            character.UVMin = glm::vec2(position) / (float)ATLAS_SIZE;
+            character.UVMax = glm::vec2(position + character.Size) / (float)ATLAS_SIZE;
+        }
+
+        _Characters.Insert(codepoint, character);
+        return true;
     }
 } // namespace nmGfx
@@ -3,31 +3,169 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 #include "glm/glm.hpp"
-#include <map>
+
+class FT_FaceRec_;
 
 namespace nmGfx
 {
+    enum class FontRenderMode
+    {
+        // coverage bitmap, blurs when scaled, use with res/text.glsl
+        BITMAP = 0,
+        // signed distance field, one atlas serves every size, use with res/text_sdf.glsl
+        SDF,
+    };
+
     class Font
     {
         public:
+            // size of a single atlas page in pixels
+            static const int ATLAS_SIZE = 1024;
+            // empty pixels around each glyph so linear filtering doesn't bleed neighbours
+            static const int GLYPH_PADDING = 1;
 
         public:
-            Font() = default;
+            Font();
             ~Font();
 
+            /**
+             * @brief Sets how many atlas pages glyphs can occupy before least recently used ones are evicted
+             *
+             * @param pages
+             */
+            inline void SetMaxAtlasPages(int pages) { _MaxPages = pages; }
+            inline int GetMaxAtlasPages() const { return _MaxPages; }
+
+            inline FontRenderMode GetRenderMode() const { return _RenderMode; }
+
+            /**
+             * @brief Decodes next utf-8 codepoint and advances iterator. Invalid sequences return U+FFFD and skip one byte
+             *
+             * @param it
+             * @param end
+             * @return uint32_t codepoint
+             */
+            static uint32_t NextCodepoint(std::string::const_iterator& it, std::string::const_iterator end);
+
         private:
             struct Character {
-                unsigned int TextureID;
+                int          Page;
+                int          Shelf;
+                glm::vec2    UVMin;
+                glm::vec2    UVMax;
                 glm::ivec2   Size;
                 glm::ivec2   Bearing;
                 unsigned int Advance;
             };
-            std::map<int, Font::Character> _Characters;
+
+            // Shelf packed single channel texture
+            struct AtlasPage {
+                struct Shelf {
+                    int y;
+                    int height;
+                    int x;
+                    // glyphs are evicted shelf by shelf
+                    uint64_t lastUsed;
+                    std::vector<uint32_t> glyphs;
+                };
+
+                unsigned int TextureID = 0;
+                std::vector<Shelf> Shelves;
+                int ShelfBottom = 0;
+            };
+
+            /**
+             * @brief Glyph lookup, dense array for latin-1 and open addressing hash for the rest. Lookups never insert
+             *
+             * Returned pointers are valid until the next Insert.
+             */
+            class GlyphTable
+            {
+                public:
+                    static const uint32_t DENSE_SIZE = 256;
+
+                    GlyphTable();
+
+                    inline const Character* Find(uint32_t codepoint) const
+                    {
+                        if(codepoint < DENSE_SIZE)
+                            return _denseUsed[codepoint] ? &_dense[codepoint] : nullptr;
+                        return FindHashed(codepoint);
+                    }
+                    Character& Insert(uint32_t codepoint, const Character& character);
+                    void Erase(uint32_t codepoint);
+                    void Clear();
+
+                private:
+                    static const uint32_t EMPTY = 0xFFFFFFFF;
+                    static const uint32_t TOMBSTONE = 0xFFFFFFFE; // both above max unicode codepoint
+
+                    struct Slot
+                    {
+                        uint32_t codepoint;
+                        Character character;
+                    };
+
+                    const Character* FindHashed(uint32_t codepoint) const;
+                    void Rehash(size_t capacity);
+                    static inline size_t Hash(uint32_t codepoint) { return codepoint * 2654435761u; }
+
+                    Character _dense[DENSE_SIZE];
+                    bool _denseUsed[DENSE_SIZE];
+
+                    std::vector<Slot> _slots; // power of two
+                    size_t _used = 0;         // including tombstones
+            };
+
+            /**
+             * @brief Returns glyph of codepoint, rasterizing it into atlas on first use. nullptr if it can't be loaded
+             *
+             * Glyphs returned since last BeginUse() are never evicted, so their uvs stay valid until the next one.
+             * Pointer is valid until the next GetCharacter call.
+             */
+            const Character* GetCharacter(uint32_t codepoint);
+            /**
+             * @brief Returns already loaded glyph without rasterizing or touching lru state
+             *
+             */
+            inline const Character* FindCharacter(uint32_t codepoint) const { return _Characters.Find(codepoint); }
+            inline void BeginUse() { _UseTick++; }
+
+            /**
+             * @brief Packs glyph bitmap into atlas and registers its metrics
+             *
+             * @param codepoint
+             * @param bitmap single channel, tightly packed rows
+             * @return false if there is no room in atlas budget
+             */
+            bool AddGlyph(uint32_t codepoint, const unsigned char* bitmap, int width, int height, glm::ivec2 bearing, unsigned int advance);
+            bool LoadGlyph(uint32_t codepoint);
+
+            bool PackRect(int width, int height, int& page, int& shelf, glm::ivec2& position);
+            bool EvictShelf(int height);
+            void AddPage();
+            void Clear();
+
+            GlyphTable _Characters;
+            float _LineHeight = 0.f;
+            FontRenderMode _RenderMode = FontRenderMode::BITMAP;
+            std::vector<AtlasPage> _Pages;
+            int _MaxPages = 4;
+            uint64_t _UseTick = 1;
+
+            // unique for lifetime of program, text layouts are keyed by it instead of address
+            uint64_t _Id;
+            // bumped when glyphs are evicted or font is reloaded, layouts built with older generation are stale
+            uint64_t _AtlasGeneration = 0;
+
+            FT_FaceRec_* _Face = nullptr;
+            std::vector<unsigned char> _FaceData; // memory fonts, must outlive _Face
 
 			friend class Renderer;
     };
 } // namespace nmGfx
 
 
-#endif // __NM_GFX_FONT_HPP__
\ No newline at end of file
+#endif // __NM_GFX_FONT_HPP__
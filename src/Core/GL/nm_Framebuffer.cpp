@@ -2,114 +2,256 @@
 #include <stdio.h>
 #include "glad/glad.h"
 #include "Core/nm_Window.hpp"
+#include "nm_StateCache.hpp"
 
 namespace nmGfx
 {
-    // todo: modulat system with customizable attachments
-    void Framebuffer::CreateGBuffer(Window* pWindow, int width, int height)
+    static GLenum GetInternalFormat(AttachmentFormat format)
     {
-        _width = width;
-        _height = height;
-        glGenFramebuffers(1, &_id);
-        glBindFramebuffer(GL_FRAMEBUFFER, _id);
+        return format == AttachmentFormat::RGBA8 ? GL_RGBA8
+            : format == AttachmentFormat::RGBA16F ? GL_RGBA16F
+            : format == AttachmentFormat::RGBA32F ? GL_RGBA32F
+            : format == AttachmentFormat::RG16F ? GL_RG16F
+            : format == AttachmentFormat::R8 ? GL_R8
+            : format == AttachmentFormat::R16F ? GL_R16F
+            : format == AttachmentFormat::R32F ? GL_R32F
+            : format == AttachmentFormat::R32I ? GL_R32I
+            : GL_NONE;
+    }
+    static GLenum GetPixelFormat(AttachmentFormat format)
+    {
+        return format == AttachmentFormat::R32I ? GL_RED_INTEGER
+            : format == AttachmentFormat::RG16F ? GL_RG
+            : format == AttachmentFormat::R8 || format == AttachmentFormat::R16F || format == AttachmentFormat::R32F ? GL_RED
+            : GL_RGBA;
+    }
+    static GLenum GetPixelType(AttachmentFormat format)
+    {
+        return format == AttachmentFormat::R32I ? GL_INT
+            : format == AttachmentFormat::RGBA8 || format == AttachmentFormat::R8 ? GL_UNSIGNED_BYTE
+            : GL_FLOAT;
+    }
+    static uint32_t GetPixelSize(AttachmentFormat format)
+    {
+        return format == AttachmentFormat::RGBA8 ? 4
+            : format == AttachmentFormat::RGBA16F ? 8
+            : format == AttachmentFormat::RGBA32F ? 16
+            : format == AttachmentFormat::RG16F ? 4
+            : format == AttachmentFormat::R8 ? 1
+            : format == AttachmentFormat::R16F ? 2
+            : format == AttachmentFormat::R32F ? 4
+            : format == AttachmentFormat::R32I ? 4
+            : 0;
+    }
+    static GLenum GetDepthFormat(DepthFormat format)
+    {
+        return format == DepthFormat::DEPTH24_STENCIL8 ? GL_DEPTH24_STENCIL8
+            : format == DepthFormat::DEPTH32F ? GL_DEPTH_COMPONENT32F
+            : GL_NONE;
+    }
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        
-        glGenTextures(1, &_gAlbedo);
-        glBindTexture(GL_TEXTURE_2D, _gAlbedo);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _gAlbedo, 0);
-        
-        glGenTextures(1, &_gPosition);
-        glBindTexture(GL_TEXTURE_2D, _gPosition);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, 0);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindFramebuffer(GL_FRAMEBUFFER, _id);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, _gPosition, 0);
-
-        glGenTextures(1, &_gNormal);
-        glBindTexture(GL_TEXTURE_2D, _gNormal);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, _gNormal, 0);
-
-        glGenTextures(1, &_gDrawID);
-        glBindTexture(GL_TEXTURE_2D, _gDrawID);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32I, width, height, 0, GL_RED_INTEGER, GL_INT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, _gDrawID, 0);
-
-        glGenRenderbuffers(1, &_depthBuffer);
-        glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
-
-        GLenum DrawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
-        glDrawBuffers(4, DrawBuffers);
 
+    FramebufferDesc::FramebufferDesc(int width, int height, AttachmentFormat format, uint32_t count /*= 1*/, DepthFormat depth /*= DepthFormat::DEPTH24_STENCIL8*/, int samples /*= 1*/)
+        : width(width), height(height), depth(depth), samples(samples)
+    {
+        colorCount = count < MAX_COLOR_ATTACHMENTS ? count : MAX_COLOR_ATTACHMENTS;
+        for(uint32_t i = 0; i < colorCount; i++)
+            colors[i] = format;
+    }
 
-#ifdef NMGFX_PRINT_MESSAGES
-        auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if(status != GL_FRAMEBUFFER_COMPLETE)
-            printf("%s, %i", "Failed generating framebuffer: ", status);
-        else
-            printf("Framebuffer Complete. id:%i\n", _id);
-#endif
+    FramebufferDesc& FramebufferDesc::AddColor(AttachmentFormat format)
+    {
+        if(colorCount < MAX_COLOR_ATTACHMENTS)
+            colors[colorCount++] = format;
+        return *this;
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    uint64_t FramebufferDesc::GetMemorySize() const
+    {
+        uint64_t pixelSize = depth == DepthFormat::NONE ? 0 : 4;
+        for(uint32_t i = 0; i < colorCount; i++)
+            pixelSize += GetPixelSize(colors[i]);
+        return pixelSize * (uint64_t)width * height * (samples > 1 ? samples : 1);
     }
 
-    void Framebuffer::Create2DDefault(Window* pWindow, int width, int height)
+    bool FramebufferDesc::operator==(const FramebufferDesc& other) const
     {
-        _width = width;
-        _height = height;
+        if(width != other.width || height != other.height || colorCount != other.colorCount || depth != other.depth)
+            return false;
+        if((samples > 1 ? samples : 1) != (other.samples > 1 ? other.samples : 1))
+            return false;
+        for(uint32_t i = 0; i < colorCount; i++)
+        {
+            if(colors[i] != other.colors[i])
+                return false;
+        }
+        return true;
+    }
+
+
+    bool Framebuffer::Create(const FramebufferDesc& desc)
+    {
+        Destroy();
+
+        _desc = desc;
+        _desc.colorCount = desc.colorCount < FramebufferDesc::MAX_COLOR_ATTACHMENTS ? desc.colorCount : FramebufferDesc::MAX_COLOR_ATTACHMENTS;
+        _desc.samples = desc.samples > 1 ? desc.samples : 1;
+        _width = desc.width;
+        _height = desc.height;
+        bool multisampled = _desc.samples > 1;
+
         glGenFramebuffers(1, &_id);
-        glBindFramebuffer(GL_FRAMEBUFFER, _id);
+        StateCache::Get().BindFramebuffer(_id);
 
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        
-        glGenTextures(1, &_gAlbedo);
-        glBindTexture(GL_TEXTURE_2D, _gAlbedo);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _gAlbedo, 0);
-
-        glGenTextures(1, &_gDrawID);
-        glBindTexture(GL_TEXTURE_2D, _gDrawID);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32I, width, height, 0, GL_RED_INTEGER, GL_INT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, _gDrawID, 0);
-
-        glGenRenderbuffers(1, &_depthBuffer);
-        glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
-
-        GLenum DrawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-        glDrawBuffers(2, DrawBuffers);
 
+        GLenum drawBuffers[FramebufferDesc::MAX_COLOR_ATTACHMENTS];
+        for(uint32_t i = 0; i < _desc.colorCount; i++)
+        {
+            AttachmentFormat format = _desc.colors[i];
+            if(format == AttachmentFormat::NONE)
+            {
+                drawBuffers[i] = GL_NONE;
+                continue;
+            }
+            drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+
+            glGenTextures(1, &_colors[i]);
+            if(multisampled)
+            {
+                // not tracked by state cache
+                glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, _colors[i]);
+                glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, _desc.samples, GetInternalFormat(format), _width, _height, GL_TRUE);
+                glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D_MULTISAMPLE, _colors[i], 0);
+            }
+            else
+            {
+                StateCache::Get().BindTexture(GL_TEXTURE_2D, _colors[i]);
+                glTexImage2D(GL_TEXTURE_2D, 0, GetInternalFormat(format), _width, _height, 0, GetPixelFormat(format), GetPixelType(format), nullptr);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, _colors[i], 0);
+            }
+        }
+
+        if(_desc.depth != DepthFormat::NONE)
+        {
+            glGenRenderbuffers(1, &_depthBuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
+            if(multisampled)
+                glRenderbufferStorageMultisample(GL_RENDERBUFFER, _desc.samples, GetDepthFormat(_desc.depth), _width, _height);
+            else
+                glRenderbufferStorage(GL_RENDERBUFFER, GetDepthFormat(_desc.depth), _width, _height);
+            GLenum attachment = _desc.depth == DepthFormat::DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, _depthBuffer);
+        }
+
+        if(_desc.colorCount > 0)
+            glDrawBuffers(_desc.colorCount, drawBuffers);
+        else
+        {
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+        }
+
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
 #ifdef NMGFX_PRINT_MESSAGES
-        auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if(status != GL_FRAMEBUFFER_COMPLETE)
-            printf("%s, %i", "Failed generating framebuffer: ", status);
+        if(!complete)
+            printf("%s, %i", "Failed generating framebuffer: ", glCheckFramebufferStatus(GL_FRAMEBUFFER));
         else
             printf("Framebuffer Complete. id:%i\n", _id);
 #endif
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        StateCache::Get().BindFramebuffer(0);
+        return complete;
+    }
+
+    void Framebuffer::CreateGBuffer(Window* pWindow, int width, int height)
+    {
+        _pWindow = pWindow;
+
+        FramebufferDesc desc(width, height, AttachmentFormat::RGBA16F, 3);
+        desc.AddColor(AttachmentFormat::R32I);
+        Create(desc);
+    }
+
+    void Framebuffer::Create2DDefault(Window* pWindow, int width, int height, bool drawIDAttachment /*= true*/)
+    {
+        _pWindow = pWindow;
+
+        FramebufferDesc desc(width, height, AttachmentFormat::RGBA16F);
+        if(drawIDAttachment)
+            desc.AddColor(AttachmentFormat::R32I);
+        Create(desc);
+    }
+
+    void Framebuffer::Destroy()
+    {
+        StateCache& stateCache = StateCache::Get();
+        for(unsigned int& texture : _colors)
+        {
+            if(texture != 0)
+            {
+                stateCache.OnTextureDeleted(texture);
+                glDeleteTextures(1, &texture);
+                texture = 0;
+            }
+        }
+        if(_depthBuffer != 0)
+            glDeleteRenderbuffers(1, &_depthBuffer);
+        if(_id != 0)
+        {
+            stateCache.OnFramebufferDeleted(_id);
+            glDeleteFramebuffers(1, &_id);
+        }
+
+        _id = 0;
+        _depthBuffer = 0;
     }
 
     void Framebuffer::Use()
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, _id);
-        glViewport(0, 0, _width, _height);
+        StateCache::Get().BindFramebuffer(_id);
+        StateCache::Get().Viewport(0, 0, _width, _height);
+    }
+
+    void Framebuffer::Resolve(Framebuffer& target, bool depth /*= false*/)
+    {
+        // state cache tracks both targets as one binding, draw target is put back afterwards
+        StateCache::Get().BindFramebuffer(_id);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target._id);
+
+        // window framebuffer, only color 0 is copied into its back buffer
+        if(target._id == 0)
+        {
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _id);
+            return;
+        }
+
+        uint32_t count = _desc.colorCount < target._desc.colorCount ? _desc.colorCount : target._desc.colorCount;
+        for(uint32_t i = 0; i < count; i++)
+        {
+            if(_colors[i] == 0 || target._colors[i] == 0)
+                continue;
+
+            GLenum drawBuffer = GL_COLOR_ATTACHMENT0 + i;
+            glReadBuffer(drawBuffer);
+            glDrawBuffers(1, &drawBuffer);
+            glBlitFramebuffer(0, 0, _width, _height, 0, 0, target._width, target._height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+        if(depth && _depthBuffer != 0 && target._depthBuffer != 0)
+            glBlitFramebuffer(0, 0, _width, _height, 0, 0, target._width, target._height, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+
+        // restore draw buffers of target
+        GLenum drawBuffers[FramebufferDesc::MAX_COLOR_ATTACHMENTS];
+        for(uint32_t i = 0; i < target._desc.colorCount; i++)
+            drawBuffers[i] = target._colors[i] != 0 ? GL_COLOR_ATTACHMENT0 + i : GL_NONE;
+        if(target._desc.colorCount > 0)
+            glDrawBuffers(target._desc.colorCount, drawBuffers);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _id);
     }
 } // namespace nmGfx
@@ -1,54 +1,138 @@
 #ifndef __NM_GFX_FRAMEBUFFER_HPP__
 #define __NM_GFX_FRAMEBUFFER_HPP__
 
+#include <stdint.h>
+
 namespace nmGfx
 {
     class Renderer;
     class Window;
 
+    enum class AttachmentFormat
+    {
+        NONE = 0,
+        RGBA8,
+        RGBA16F,
+        RGBA32F,
+        RG16F,
+        R8,
+        R16F,
+        R32F,
+        R32I,
+    };
+
+    enum class DepthFormat
+    {
+        NONE = 0,
+        DEPTH24_STENCIL8,
+        DEPTH32F,
+    };
+
+    /**
+     * @brief Describes attachments of a framebuffer
+     *
+     * Color attachment i is GL_COLOR_ATTACHMENTi and fragment output location i.
+     * NONE leaves a gap, outputs of shaders written for a bigger layout are discarded.
+     */
+    struct FramebufferDesc
+    {
+        static const uint32_t MAX_COLOR_ATTACHMENTS = 8;
+
+        int width = 0;
+        int height = 0;
+        AttachmentFormat colors[MAX_COLOR_ATTACHMENTS] = {};
+        uint32_t colorCount = 0;
+        DepthFormat depth = DepthFormat::DEPTH24_STENCIL8;
+        int samples = 1; // > 1 -> multisampled, see Framebuffer::Resolve
+
+        FramebufferDesc() = default;
+        // count attachments of the same format
+        FramebufferDesc(int width, int height, AttachmentFormat format, uint32_t count = 1, DepthFormat depth = DepthFormat::DEPTH24_STENCIL8, int samples = 1);
+
+        // Appends attachment, returns *this for chaining
+        FramebufferDesc& AddColor(AttachmentFormat format);
+
+        // Bytes of gpu memory attachments take
+        uint64_t GetMemorySize() const;
+
+        bool operator==(const FramebufferDesc& other) const;
+        inline bool operator!=(const FramebufferDesc& other) const { return !(*this == other); }
+    };
+
     class Framebuffer
     {
         public:
             Framebuffer() = default;
 
             /**
-             * @brief Creates default framebuffer with gBuffer layout
-             * 
-             * vec4 gAlbedoSpec
-             * vec3 gPosition
-             * vec3 gNormal
-             * unsigned int drawID
-             * 
-             * @param width 
-             * @param height 
+             * @brief Creates framebuffer with attachments in desc
+             *
+             * Single sampled attachments are textures that can be sampled, depth is a renderbuffer.
+             * Multisampled color attachments are GL_TEXTURE_2D_MULTISAMPLE textures.
+             *
+             * @param desc
+             * @return true if framebuffer is complete
+             */
+            bool Create(const FramebufferDesc& desc);
+
+            /**
+             * @brief Creates framebuffer with full gBuffer layout, 32 bytes per pixel with depth
+             *
+             * vec4 gAlbedoSpec (RGBA16F)
+             * vec3 gPosition (RGBA16F)
+             * vec3 gNormal (RGBA16F)
+             * unsigned int drawID (R32I)
+             *
+             * Kept for compatibility. Renderer uses a trimmed desc without storage for position and
+             * normal, which no pass reads, 16 bytes per pixel.
+             *
+             * @param width
+             * @param height
              */
             void CreateGBuffer(Window* pWindow, int width, int height);
 
             /**
              * @brief Creates default framebuffer with gBuffer layout
-             * 
+             *
              * vec4 Color
              * unsigned int drawID
-             * 
-             * @param width 
-             * @param height 
+             *
+             * @param width
+             * @param height
+             * @param drawIDAttachment false skips the drawID attachment, ids written by shaders are discarded
              */
-            void Create2DDefault(Window* pWindow, int width, int height);
+            void Create2DDefault(Window* pWindow, int width, int height, bool drawIDAttachment = true);
+
+            // Deletes framebuffer and its attachments
+            void Destroy();
 
             void Use();
 
-            inline unsigned int GetAlbedoID() { return _gAlbedo; }
+            /**
+             * @brief Copies attachments into target, resolving samples when this framebuffer is multisampled
+             *
+             * Color attachments present in both framebuffers are copied. Sizes must match when resolving.
+             *
+             * @param target
+             * @param depth also copy depth and stencil, formats must match
+             */
+            void Resolve(Framebuffer& target, bool depth = false);
+
+            inline unsigned int GetAlbedoID() { return _colors[0]; }
+            // 0 if attachment isn't in desc
+            inline unsigned int GetColorID(uint32_t index) const { return index < FramebufferDesc::MAX_COLOR_ATTACHMENTS ? _colors[index] : 0; }
+            inline const FramebufferDesc& GetDesc() const { return _desc; }
+            inline int GetWidth() const { return _desc.width; }
+            inline int GetHeight() const { return _desc.height; }
 
         private:
             unsigned int _id = 0;
 
-            unsigned int _gAlbedo;
-            unsigned int _gPosition;
-            unsigned int _gNormal;
-            unsigned int _gDrawID;
+            FramebufferDesc _desc;
+            unsigned int _colors[FramebufferDesc::MAX_COLOR_ATTACHMENTS] = {};
+
+            unsigned int _depthBuffer = 0;
 
-            unsigned int _depthBuffer;
-            
 
             friend class Renderer;
 
@@ -56,9 +140,9 @@ namespace nmGfx
             int _height = 0;
 
 
-            Window* _pWindow; // handle to window used for getting window size
+            Window* _pWindow = nullptr; // handle to window used for getting window size
     };
 } // namespace nmGfx
 
 
-#endif // __NM_GFX_FRAMEBUFFER_HPP__
\ No newline at end of file
+#endif // __NM_GFX_FRAMEBUFFER_HPP__
@@ -0,0 +1,203 @@
+#include "nm_Layer2D.hpp"
+#include <math.h>
+#include "Core/nm_Matrix.hpp"
+
+namespace nmGfx
+{
+    Layer2D::~Layer2D()
+    {
+        Destroy();
+    }
+
+    bool Layer2D::Create(int width, int height)
+    {
+        // no draw id attachment, retained sprites aren't pickable
+        FramebufferDesc desc(width, height, AttachmentFormat::RGBA16F);
+        bool complete = _framebuffer.Create(desc);
+
+        SetView(glm::mat4(1.f));
+        Invalidate();
+        return complete;
+    }
+
+    void Layer2D::Destroy()
+    {
+        _framebuffer.Destroy();
+    }
+
+    void Layer2D::SetView(const glm::mat4& cameraTransform, const glm::vec2& cameraCenter /*= {0.5f, 0.5f}*/)
+    {
+        glm::mat4 projection = CalculateProjectionMatrix((float)_framebuffer.GetWidth(), (float)_framebuffer.GetHeight(), cameraCenter.x, cameraCenter.y, 0.f, 10.f);
+        glm::mat4 viewProjection = projection * glm::inverse(cameraTransform);
+        if(viewProjection == _viewProjection)
+            return;
+
+        _viewProjection = viewProjection;
+        for(Sprite& sprite : _sprites)
+        {
+            if(sprite.sequence != 0)
+                UpdateBounds(sprite);
+        }
+        Invalidate();
+    }
+
+    void Layer2D::SetClearColor(const glm::vec4& clearColor)
+    {
+        if(clearColor == _clearColor)
+            return;
+        _clearColor = clearColor;
+        Invalidate();
+    }
+
+    Layer2D::SpriteHandle Layer2D::AddSprite(Texture* texture, const glm::mat4& transform, const glm::vec4& tint /*= glm::vec4(1.f)*/, int drawID /*= 0*/)
+    {
+        SpriteHandle handle;
+        if(!_freeSprites.empty())
+        {
+            handle = _freeSprites.back();
+            _freeSprites.pop_back();
+        }
+        else
+        {
+            handle = (SpriteHandle)_sprites.size();
+            _sprites.emplace_back();
+        }
+
+        Sprite& sprite = _sprites[handle];
+        sprite.texture = texture;
+        sprite.transform = transform;
+        sprite.tint = tint;
+        sprite.drawID = drawID;
+        sprite.sequence = _nextSequence++;
+        sprite.drawnTextureID = 0;
+        UpdateBounds(sprite);
+        MarkDirty(sprite.min, sprite.max);
+        return handle;
+    }
+
+    void Layer2D::SetSprite(SpriteHandle handle, Texture* texture, const glm::mat4& transform, const glm::vec4& tint /*= glm::vec4(1.f)*/, int drawID /*= 0*/)
+    {
+        if(!IsValid(handle))
+            return;
+
+        Sprite& sprite = _sprites[handle];
+        if(sprite.texture == texture && sprite.transform == transform && sprite.tint == tint && sprite.drawID == drawID)
+            return;
+
+        MarkDirty(sprite.min, sprite.max);
+        sprite.texture = texture;
+        sprite.transform = transform;
+        sprite.tint = tint;
+        sprite.drawID = drawID;
+        UpdateBounds(sprite);
+        MarkDirty(sprite.min, sprite.max);
+    }
+
+    void Layer2D::SetSpriteTransform(SpriteHandle handle, const glm::mat4& transform)
+    {
+        if(IsValid(handle))
+            SetSprite(handle, _sprites[handle].texture, transform, _sprites[handle].tint, _sprites[handle].drawID);
+    }
+
+    void Layer2D::SetSpriteTint(SpriteHandle handle, const glm::vec4& tint)
+    {
+        if(IsValid(handle))
+            SetSprite(handle, _sprites[handle].texture, _sprites[handle].transform, tint, _sprites[handle].drawID);
+    }
+
+    void Layer2D::RemoveSprite(SpriteHandle handle)
+    {
+        if(!IsValid(handle))
+            return;
+
+        Sprite& sprite = _sprites[handle];
+        MarkDirty(sprite.min, sprite.max);
+        sprite.sequence = 0;
+        sprite.texture = nullptr;
+        _freeSprites.push_back(handle);
+    }
+
+    void Layer2D::Clear()
+    {
+        _sprites.clear();
+        _freeSprites.clear();
+        Invalidate();
+    }
+
+    void Layer2D::Invalidate()
+    {
+        _dirtyRects.clear();
+        AddDirtyRect(Rect(0, 0, _framebuffer.GetWidth(), _framebuffer.GetHeight()));
+    }
+
+    void Layer2D::InvalidateRect(int x, int y, int width, int height)
+    {
+        AddDirtyRect(Rect(x, y, x + width, y + height));
+    }
+
+    bool Layer2D::IsValid(SpriteHandle handle) const
+    {
+        return handle < _sprites.size() && _sprites[handle].sequence != 0;
+    }
+
+    void Layer2D::UpdateBounds(Sprite& sprite)
+    {
+        // same corners as Renderer::DrawTexture
+        static const glm::vec4 corners[4] = {
+            {-0.5f,  0.5f, 0.f, 1.f},
+            {-0.5f, -0.5f, 0.f, 1.f},
+            { 0.5f, -0.5f, 0.f, 1.f},
+            { 0.5f,  0.5f, 0.f, 1.f},
+        };
+
+        glm::vec2 size((float)_framebuffer.GetWidth(), (float)_framebuffer.GetHeight());
+        for(int i = 0; i < 4; i++)
+        {
+            glm::vec4 clip = _viewProjection * (sprite.transform * corners[i]);
+            glm::vec2 pixel = (glm::vec2(clip) / clip.w * 0.5f + 0.5f) * size;
+            sprite.min = i == 0 ? pixel : glm::min(sprite.min, pixel);
+            sprite.max = i == 0 ? pixel : glm::max(sprite.max, pixel);
+        }
+    }
+
+    void Layer2D::MarkDirty(const glm::vec2& min, const glm::vec2& max)
+    {
+        // a pixel of margin for texels rasterized across the rounded edge
+        AddDirtyRect(Rect((int)floorf(min.x) - 1, (int)floorf(min.y) - 1, (int)ceilf(max.x) + 1, (int)ceilf(max.y) + 1));
+    }
+
+    void Layer2D::AddDirtyRect(Rect rect)
+    {
+        int width = _framebuffer.GetWidth();
+        int height = _framebuffer.GetHeight();
+        rect = glm::clamp(rect, Rect(0), Rect(width, height, width, height));
+        if(rect.x >= rect.z || rect.y >= rect.w)
+            return;
+
+        // merge with every rectangle it touches until none is left, so rectangles never overlap
+        bool merged = true;
+        while(merged)
+        {
+            merged = false;
+            for(size_t i = 0; i < _dirtyRects.size(); i++)
+            {
+                const Rect& other = _dirtyRects[i];
+                if(rect.x > other.z || other.x > rect.z || rect.y > other.w || other.y > rect.w)
+                    continue;
+
+                rect = Rect(glm::min(glm::ivec2(rect), glm::ivec2(other)), glm::max(glm::ivec2(rect.z, rect.w), glm::ivec2(other.z, other.w)));
+                _dirtyRects[i] = _dirtyRects.back();
+                _dirtyRects.pop_back();
+                merged = true;
+                break;
+            }
+        }
+
+        if(_dirtyRects.size() == MAX_DIRTY_RECTS)
+        {
+            Invalidate();
+            return;
+        }
+        _dirtyRects.push_back(rect);
+    }
+} // namespace nmGfx
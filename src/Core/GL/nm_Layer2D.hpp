@@ -0,0 +1,127 @@
+#ifndef __NM_GFX_LAYER_2D_HPP__
+#define __NM_GFX_LAYER_2D_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "nm_Framebuffer.hpp"
+
+namespace nmGfx
+{
+    class Texture;
+
+    /**
+     * @brief Retained 2d layer, sprites stay in it between frames and are cached in its own framebuffer
+     *
+     * Adding, changing or removing a sprite marks the pixels it covered and covers as dirty.
+     * Renderer::UpdateLayer2D clears only the dirty rectangles with scissor and redraws the
+     * sprites touching them, a layer that didn't change costs nothing. Composite it with
+     * Renderer::AddPassLayer(layer.GetFramebuffer()).
+     */
+    class Layer2D
+    {
+        public:
+            using SpriteHandle = uint32_t;
+            static const SpriteHandle INVALID_SPRITE = 0xFFFFFFFF;
+            // more dirty rectangles than this redraw the whole layer
+            static const uint32_t MAX_DIRTY_RECTS = 8;
+
+            struct Stats
+            {
+                uint32_t rects = 0;
+                uint32_t sprites = 0; // sprite draws, sprites touching several rectangles count for each
+                uint64_t pixels = 0;
+            };
+
+        public:
+            Layer2D() = default;
+            ~Layer2D();
+            Layer2D(const Layer2D&) = delete;
+            Layer2D& operator=(const Layer2D&) = delete;
+
+            /**
+             * @brief Creates framebuffer of layer, size is usually video size
+             *
+             * @param width
+             * @param height
+             * @return true if framebuffer is complete
+             */
+            bool Create(int width, int height);
+            void Destroy();
+
+            /**
+             * @brief Sets camera like Begin2D does, redraws whole layer when it changes
+             *
+             */
+            void SetView(const glm::mat4& cameraTransform, const glm::vec2& cameraCenter = {0.5f, 0.5f});
+            void SetClearColor(const glm::vec4& clearColor);
+
+            /**
+             * @brief Adds sprite on top of the ones already in layer. Texture must stay alive while sprite uses it
+             *
+             * @param texture nullptr draws white
+             * @param transform
+             * @param tint
+             * @param drawID
+             * @return SpriteHandle
+             */
+            SpriteHandle AddSprite(Texture* texture, const glm::mat4& transform, const glm::vec4& tint = glm::vec4(1.f), int drawID = 0);
+            void SetSprite(SpriteHandle sprite, Texture* texture, const glm::mat4& transform, const glm::vec4& tint = glm::vec4(1.f), int drawID = 0);
+            void SetSpriteTransform(SpriteHandle sprite, const glm::mat4& transform);
+            void SetSpriteTint(SpriteHandle sprite, const glm::vec4& tint);
+            void RemoveSprite(SpriteHandle sprite);
+            // Removes every sprite
+            void Clear();
+
+            // Redraws whole layer on next update
+            void Invalidate();
+            void InvalidateRect(int x, int y, int width, int height);
+            inline bool IsDirty() const { return !_dirtyRects.empty(); }
+
+            inline Framebuffer& GetFramebuffer() { return _framebuffer; }
+            inline unsigned int GetTextureID() { return _framebuffer.GetAlbedoID(); }
+            inline size_t GetSpriteCount() const { return _sprites.size() - _freeSprites.size(); }
+            // What last Renderer::UpdateLayer2D redrew
+            inline const Stats& GetStats() const { return _stats; }
+
+        private:
+            struct Sprite
+            {
+                Texture* texture;
+                glm::mat4 transform;
+                glm::vec4 tint;
+                int drawID;
+                uint64_t sequence; // draw order, 0 -> removed
+                glm::vec2 min; // bounds in framebuffer pixels
+                glm::vec2 max;
+                unsigned int drawnTextureID; // texture id sprite was last drawn with
+            };
+
+            // x0, y0, x1, y1 in pixels, x1 and y1 exclusive
+            using Rect = glm::ivec4;
+
+            bool IsValid(SpriteHandle sprite) const;
+            void UpdateBounds(Sprite& sprite);
+            void MarkDirty(const glm::vec2& min, const glm::vec2& max);
+            void AddDirtyRect(Rect rect);
+
+            Framebuffer _framebuffer;
+            glm::vec4 _clearColor = glm::vec4(0.f);
+            glm::mat4 _viewProjection = glm::mat4(1.f);
+
+            std::vector<Sprite> _sprites;
+            std::vector<SpriteHandle> _freeSprites;
+            uint64_t _nextSequence = 1;
+
+            std::vector<Rect> _dirtyRects; // don't overlap each other
+            Stats _stats;
+
+            friend class Renderer;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_LAYER_2D_HPP__
@@ -0,0 +1,186 @@
+#include "nm_MeshFile.hpp"
+#include <stdio.h>
+#include <string.h>
+
+#include "Core/nm_ObjParser.hpp"
+
+namespace nmGfx
+{
+    static const uint64_t MESH_FILE_ALIGNMENT = 16;
+    // GL_MAX_VERTEX_ATTRIBS is at least 16 everywhere
+    static const uint32_t MAX_ATTRIBUTE_SLOTS = 16;
+
+    static uint64_t AlignOffset(uint64_t offset)
+    {
+        return (offset + MESH_FILE_ALIGNMENT - 1) & ~(MESH_FILE_ALIGNMENT - 1);
+    }
+
+    static uint32_t GetOptimizeFlags(const MeshOptimizeSettings& optimize)
+    {
+        return (optimize.vertexCache ? MeshFileHeader::OPTIMIZE_VERTEX_CACHE : 0)
+             | (optimize.overdraw ? MeshFileHeader::OPTIMIZE_OVERDRAW : 0)
+             | (optimize.vertexFetch ? MeshFileHeader::OPTIMIZE_VERTEX_FETCH : 0);
+    }
+
+    bool MeshFile::Open(const char* path)
+    {
+        Close();
+        if(!_file.Open(path))
+            return false;
+
+        if(_file.Size() < sizeof(MeshFileHeader))
+        {
+            Close();
+            return false;
+        }
+
+        const MeshFileHeader* header = (const MeshFileHeader*)_file.Data();
+        uint64_t attributesEnd = sizeof(MeshFileHeader) + (uint64_t)header->attributeCount * sizeof(MeshFileAttribute);
+        uint64_t indexSize = (uint64_t)header->indexCount * (header->indexType == (uint32_t)IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+
+        bool valid = header->magic == MeshFileHeader::MAGIC
+                  && header->version == MeshFileHeader::VERSION
+                  && header->indexType <= (uint32_t)IndexType::UINT32
+                  && attributesEnd <= _file.Size()
+                  && header->vertexSize == (uint64_t)header->vertexStride * header->vertexCount
+                  && header->vertexOffset >= attributesEnd
+                  && header->vertexSize <= _file.Size() && header->vertexOffset <= _file.Size() - header->vertexSize
+                  && header->indexSize == indexSize
+                  && header->indexOffset >= header->vertexOffset + header->vertexSize
+                  && header->indexSize <= _file.Size() && header->indexOffset <= _file.Size() - header->indexSize;
+        if(!valid)
+        {
+            Close();
+            return false;
+        }
+
+        // attributes have to be known types and cover the stride exactly, or vertices would be read misaligned
+        const MeshFileAttribute* attributes = (const MeshFileAttribute*)(_file.Data() + sizeof(MeshFileHeader));
+        uint64_t attributesSize = 0;
+        for(uint32_t i = 0; i < header->attributeCount; i++)
+        {
+            if(attributes[i].type == (uint32_t)AttributeType::NONE || attributes[i].type > (uint32_t)AttributeType::UNORM16x2
+            || attributes[i].slot >= MAX_ATTRIBUTE_SLOTS)
+            {
+                Close();
+                return false;
+            }
+            attributesSize += GetAttributeSize((AttributeType)attributes[i].type);
+        }
+        if(attributesSize != header->vertexStride)
+        {
+            Close();
+            return false;
+        }
+
+        _header = header;
+        _attributes = attributes;
+        return true;
+    }
+
+    bool MeshFile::IsCookedWith(const MeshOptimizeSettings& optimize, VertexQuantization quantization) const
+    {
+        // threshold only matters when overdraw pass ran
+        return _header->quantization == (uint32_t)quantization
+            && _header->optimizeFlags == GetOptimizeFlags(optimize)
+            && (!optimize.overdraw || _header->overdrawThreshold == optimize.overdrawThreshold);
+    }
+
+    void MeshFile::Close()
+    {
+        _file.Close();
+        _header = nullptr;
+        _attributes = nullptr;
+    }
+
+    bool MeshFile::Write(const char* path, const std::vector<MeshFileAttribute>& attributes,
+        const void* vertexData, uint32_t vertexStride, uint32_t vertexCount,
+        const void* indexData, uint32_t indexCount, IndexType indexType,
+        const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+        const MeshOptimizeSettings& optimize, VertexQuantization quantization)
+    {
+        MeshFileHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = MeshFileHeader::MAGIC;
+        header.version = MeshFileHeader::VERSION;
+        header.attributeCount = attributes.size();
+        header.vertexStride = vertexStride;
+        header.vertexCount = vertexCount;
+        header.indexCount = indexCount;
+        header.indexType = (uint32_t)indexType;
+        header.quantization = (uint32_t)quantization;
+        header.optimizeFlags = GetOptimizeFlags(optimize);
+        header.overdrawThreshold = optimize.overdrawThreshold;
+        for(int i = 0; i < 3; i++)
+        {
+            header.boundsMin[i] = boundsMin[i];
+            header.boundsMax[i] = boundsMax[i];
+        }
+        header.vertexOffset = AlignOffset(sizeof(MeshFileHeader) + attributes.size() * sizeof(MeshFileAttribute));
+        header.vertexSize = (uint64_t)vertexStride * vertexCount;
+        header.indexOffset = AlignOffset(header.vertexOffset + header.vertexSize);
+        header.indexSize = (uint64_t)indexCount * (indexType == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+
+        FILE* file = fopen(path, "wb");
+        if(file == nullptr)
+            return false;
+
+        static const unsigned char padding[MESH_FILE_ALIGNMENT] = {};
+        uint64_t written = 0;
+        auto write = [&](const void* data, uint64_t size) {
+            if(size > 0 && fwrite(data, 1, size, file) != size)
+                return false;
+            written += size;
+            return true;
+        };
+        auto pad = [&](uint64_t offset) { return write(padding, offset - written); };
+
+        bool ok = write(&header, sizeof(header))
+               && write(attributes.data(), attributes.size() * sizeof(MeshFileAttribute))
+               && pad(header.vertexOffset)
+               && write(vertexData, header.vertexSize)
+               && pad(header.indexOffset)
+               && write(indexData, header.indexSize);
+
+        ok = fclose(file) == 0 && ok;
+        if(!ok)
+            remove(path);
+        return ok;
+    }
+
+    bool MeshFile::Cook(const char* objPath, const char* meshPath, const MeshOptimizeSettings& optimize, VertexQuantization quantization)
+    {
+        std::vector<float> vertexData;
+        std::vector<uint32_t> indexData;
+        if(!ParseObjParallel(objPath, vertexData, indexData))
+            return false;
+
+        OptimizeMesh(vertexData, 8, indexData, optimize);
+
+        glm::vec3 boundsMin, boundsMax;
+        CalculateBounds(vertexData, 8, boundsMin, boundsMax);
+
+        std::vector<uint8_t> packed;
+        std::vector<VertexAttribute> vertexAttributes;
+        uint32_t stride = QuantizeObjVertices(vertexData, quantization, packed, vertexAttributes);
+
+        std::vector<MeshFileAttribute> attributes;
+        for(const VertexAttribute& attribute : vertexAttributes)
+            attributes.push_back({ attribute.slot, (uint32_t)attribute.type });
+
+        uint32_t vertexCount = vertexData.size() / 8;
+        if(vertexCount <= 0xFFFF)
+        {
+            std::vector<uint16_t> indices16(indexData.begin(), indexData.end());
+            return Write(meshPath, attributes, packed.data(), stride, vertexCount,
+                indices16.data(), indices16.size(), IndexType::UINT16, boundsMin, boundsMax, optimize, quantization);
+        }
+        return Write(meshPath, attributes, packed.data(), stride, vertexCount,
+            indexData.data(), indexData.size(), IndexType::UINT32, boundsMin, boundsMax, optimize, quantization);
+    }
+
+    std::string MeshFile::GetCachePath(const char* sourcePath)
+    {
+        return std::string(sourcePath) + ".nmesh";
+    }
+} // namespace nmGfx
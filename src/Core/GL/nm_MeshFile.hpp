@@ -0,0 +1,131 @@
+#ifndef __NM_GFX_MESH_FILE_HPP__
+#define __NM_GFX_MESH_FILE_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+
+#include "nm_Model.hpp"
+#include "Core/nm_MappedFile.hpp"
+#include "Core/nm_MeshOptimizer.hpp"
+
+namespace nmGfx
+{
+    /**
+     * @brief Binary mesh file, little endian
+     *
+     * header | attributes[attributeCount] | vertex blob (at vertexOffset) | index blob (at indexOffset)
+     * Blobs are 16 byte aligned and uploaded as is.
+     */
+    struct MeshFileHeader
+    {
+        static const uint32_t MAGIC = 0x48534D4E; // "NMSH"
+        static const uint32_t VERSION = 2;
+
+        // optimizeFlags bits
+        static const uint32_t OPTIMIZE_VERTEX_CACHE = 1;
+        static const uint32_t OPTIMIZE_OVERDRAW = 2;
+        static const uint32_t OPTIMIZE_VERTEX_FETCH = 4;
+
+        uint32_t magic;
+        uint32_t version;
+        uint32_t attributeCount;
+        uint32_t vertexStride; // bytes
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t indexType; // IndexType
+        // settings mesh was cooked with
+        uint32_t quantization; // VertexQuantization
+        uint32_t optimizeFlags;
+        float overdrawThreshold;
+        float boundsMin[3];
+        float boundsMax[3];
+        uint64_t vertexOffset;
+        uint64_t vertexSize;
+        uint64_t indexOffset;
+        uint64_t indexSize;
+    };
+
+    struct MeshFileAttribute
+    {
+        uint32_t slot;
+        uint32_t type; // AttributeType
+    };
+
+    /**
+     * @brief Memory mapped mesh file, blobs point directly into mapping
+     *
+     */
+    class MeshFile
+    {
+        public:
+            /**
+             * @brief Maps file and validates header, sizes and offsets
+             *
+             * @param path
+             * @return false if file is missing, truncated, has different version or attributes that don't match vertex stride
+             */
+            bool Open(const char* path);
+            void Close();
+
+            inline const MeshFileHeader& GetHeader() const { return *_header; }
+            inline const MeshFileAttribute* GetAttributes() const { return _attributes; }
+            inline const void* GetVertexData() const { return _file.Data() + _header->vertexOffset; }
+            inline const void* GetIndexData() const { return _file.Data() + _header->indexOffset; }
+
+            // Whether mesh was cooked with these settings, Model::LoadFromFile parses obj again otherwise
+            bool IsCookedWith(const MeshOptimizeSettings& optimize, VertexQuantization quantization) const;
+
+            /**
+             * @brief Writes mesh file
+             *
+             * @param path
+             * @param attributes
+             * @param vertexData interleaved vertices
+             * @param vertexStride bytes
+             * @param vertexCount
+             * @param indexData
+             * @param indexCount
+             * @param indexType
+             * @param boundsMin
+             * @param boundsMax
+             * @param optimize settings vertex and index data were optimized with
+             * @param quantization settings vertex data was packed with
+             * @return false if file can't be written
+             */
+            static bool Write(const char* path, const std::vector<MeshFileAttribute>& attributes,
+                const void* vertexData, uint32_t vertexStride, uint32_t vertexCount,
+                const void* indexData, uint32_t indexCount, IndexType indexType,
+                const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                const MeshOptimizeSettings& optimize, VertexQuantization quantization);
+
+            /**
+             * @brief Loads obj, optimizes it and writes it as mesh file in the same layout Model::LoadFromFile produces
+             *
+             * @param objPath
+             * @param meshPath
+             * @param optimize
+             * @param quantization vertex format
+             * @return false if obj can't be loaded or mesh file can't be written
+             */
+            static bool Cook(const char* objPath, const char* meshPath, const MeshOptimizeSettings& optimize = MeshOptimizeSettings(), VertexQuantization quantization = VertexQuantization::NONE);
+
+            /**
+             * @brief Mesh file path Model::LoadFromFile looks for next to source file
+             *
+             * @param sourcePath
+             * @return std::string
+             */
+            static std::string GetCachePath(const char* sourcePath);
+
+        private:
+            MappedFile _file;
+            const MeshFileHeader* _header = nullptr;
+            const MeshFileAttribute* _attributes = nullptr;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_MESH_FILE_HPP__
@@ -1,14 +1,17 @@
 #include "nm_Model.hpp"
 #include <vector>
+#include <unordered_map>
+#include <string.h>
+#include <math.h>
 #include "glad/glad.h"
 #include "tiny_obj_loader.h"
+#include "nm_MeshFile.hpp"
+#include "Core/nm_ObjParser.hpp"
 
 namespace nmGfx
 {
-    void Model::LoadFromFile(const char* path)
+    bool LoadObjMesh(const char* path, std::vector<float>& vertexData, std::vector<uint32_t>& indexData)
     {
-        Create();
-
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
@@ -25,11 +28,20 @@ namespace nmGfx
 #endif
         }
 
+        if(!ret)
+            return false;
+
         // layout -> vec3 pos, vec3 normal, vec2 uv
-        std::vector<float> vertexData;
-        std::vector<unsigned int> indexData;
-        bool hasNormals = false;
-        bool hasTexCoords = false;
+        vertexData.clear();
+        indexData.clear();
+
+        // corners sharing the same position/normal/texcoord indices become one vertex
+        std::unordered_map<tinyobj::index_t, uint32_t, ObjIndexHash, ObjIndexEqual> uniqueVertices;
+        size_t cornerCount = 0;
+        for (const auto& shape : shapes)
+            cornerCount += shape.mesh.indices.size();
+        uniqueVertices.reserve(cornerCount);
+        indexData.reserve(cornerCount);
 
         for (size_t s = 0; s < shapes.size(); s++)
         {
@@ -41,7 +53,11 @@ namespace nmGfx
                 for (size_t v = 0; v < fv; v++)
                 {
                     tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-                    indexData.push_back(indexData.size());
+
+                    auto inserted = uniqueVertices.emplace(idx, (uint32_t)(vertexData.size() / 8));
+                    indexData.push_back(inserted.first->second);
+                    if (!inserted.second)
+                        continue;
 
                     tinyobj::real_t vx = attrib.vertices[3*size_t(idx.vertex_index)+0];
                     tinyobj::real_t vy = attrib.vertices[3*size_t(idx.vertex_index)+1];
@@ -61,8 +77,6 @@ namespace nmGfx
                         vertexData.push_back(nx);
                         vertexData.push_back(ny);
                         vertexData.push_back(nz);
-
-                        hasNormals = true;
                     }
                     else
                     {
@@ -79,8 +93,6 @@ namespace nmGfx
 
                         vertexData.push_back(tx);
                         vertexData.push_back(ty);
-
-                        hasTexCoords = true;
                     }
                     else
                     {
@@ -94,26 +106,255 @@ namespace nmGfx
                     // tinyobj::real_t blue  = attrib.colors[3*size_t(idx.vertex_index)+2];
                 }
                 index_offset += fv;
+            }
+        }
+
+        return true;
+    }
+
+    // round to nearest even, overflow becomes infinity
+    static uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t floatExponent = (bits >> 23) & 0xFF;
+        uint32_t mantissa = bits & 0x7FFFFF;
+        int32_t exponent = (int32_t)floatExponent - 127 + 15;
+
+        if(floatExponent == 0xFF)
+            return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+        if(exponent >= 31)
+            return sign | 0x7C00;
+
+        if(exponent <= 0)
+        {
+            // subnormal half
+            if(exponent < -10)
+                return sign;
+            mantissa |= 0x800000;
+            uint32_t shift = 14 - exponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if(remainder > halfway || (remainder == halfway && (half & 1)))
+                half++;
+            return sign | half;
+        }
+
+        // carry from rounding moves into exponent, which is still correct
+        uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1FFF;
+        if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+            half++;
+        return half;
+    }
+
+    static uint32_t PackSnorm10(float value)
+    {
+        value = value < -1.f ? -1.f : value > 1.f ? 1.f : value;
+        return (uint32_t)(int32_t)roundf(value * 511.f) & 0x3FF;
+    }
+
+    static uint16_t PackUnorm16(float value)
+    {
+        value = value < 0.f ? 0.f : value > 1.f ? 1.f : value;
+        return (uint16_t)roundf(value * 65535.f);
+    }
+
+    template<typename T>
+    static void WritePacked(uint8_t*& out, T value)
+    {
+        memcpy(out, &value, sizeof(T));
+        out += sizeof(T);
+    }
 
-                // per-face material
-                shapes[s].mesh.material_ids[f];
+    uint32_t QuantizeObjVertices(const std::vector<float>& vertexData, VertexQuantization quantization, std::vector<uint8_t>& packed, std::vector<VertexAttribute>& attributes)
+    {
+        size_t vertexCount = vertexData.size() / 8;
+        attributes.clear();
+
+        if(quantization == VertexQuantization::NONE)
+        {
+            attributes.push_back({ 0, AttributeType::VEC3 });
+            attributes.push_back({ 1, AttributeType::VEC3 });
+            attributes.push_back({ 2, AttributeType::VEC2 });
+            packed.resize(vertexData.size() * sizeof(float));
+            memcpy(packed.data(), vertexData.data(), packed.size());
+            return 8 * sizeof(float);
+        }
+
+        // unorm can't repeat, tiled uvs fall back to half
+        bool uvsInRange = true;
+        for(size_t v = 0; v < vertexCount && uvsInRange; v++)
+        {
+            float u = vertexData[v * 8 + 6];
+            float t = vertexData[v * 8 + 7];
+            uvsInRange = u >= 0.f && u <= 1.f && t >= 0.f && t <= 1.f;
+        }
+
+        bool halfPositions = quantization == VertexQuantization::HALF;
+        attributes.push_back({ 0, halfPositions ? AttributeType::HALF4 : AttributeType::VEC3 });
+        attributes.push_back({ 1, AttributeType::INT_2_10_10_10_REV });
+        attributes.push_back({ 2, uvsInRange ? AttributeType::UNORM16x2 : AttributeType::HALF2 });
+
+        uint32_t stride = (halfPositions ? 8 : 12) + 4 + 4;
+        packed.resize(vertexCount * stride);
+        uint8_t* out = packed.data();
+        for(size_t v = 0; v < vertexCount; v++)
+        {
+            const float* vertex = &vertexData[v * 8];
+
+            if(halfPositions)
+            {
+                WritePacked(out, FloatToHalf(vertex[0]));
+                WritePacked(out, FloatToHalf(vertex[1]));
+                WritePacked(out, FloatToHalf(vertex[2]));
+                WritePacked(out, FloatToHalf(1.f));
+            }
+            else
+            {
+                WritePacked(out, vertex[0]);
+                WritePacked(out, vertex[1]);
+                WritePacked(out, vertex[2]);
+            }
+
+            WritePacked(out, PackSnorm10(vertex[3]) | (PackSnorm10(vertex[4]) << 10) | (PackSnorm10(vertex[5]) << 20));
+
+            if(uvsInRange)
+            {
+                WritePacked(out, PackUnorm16(vertex[6]));
+                WritePacked(out, PackUnorm16(vertex[7]));
+            }
+            else
+            {
+                WritePacked(out, FloatToHalf(vertex[6]));
+                WritePacked(out, FloatToHalf(vertex[7]));
             }
         }
+        return stride;
+    }
+
+    void CalculateBounds(const std::vector<float>& vertexData, uint32_t stride, glm::vec3& boundsMin, glm::vec3& boundsMax)
+    {
+        if(vertexData.size() < stride)
+        {
+            boundsMin = boundsMax = glm::vec3(0.f);
+            return;
+        }
+
+        boundsMin = boundsMax = glm::vec3(vertexData[0], vertexData[1], vertexData[2]);
+        for(size_t i = stride; i + 2 < vertexData.size(); i += stride)
+        {
+            glm::vec3 position(vertexData[i], vertexData[i + 1], vertexData[i + 2]);
+            boundsMin = glm::min(boundsMin, position);
+            boundsMax = glm::max(boundsMax, position);
+        }
+    }
+
+    void Model::LoadFromFile(const char* path, const MeshOptimizeSettings& optimize, VertexQuantization quantization)
+    {
+        std::string cachePath = MeshFile::GetCachePath(path);
+        if(MappedFile::GetModifiedTime(cachePath.c_str()) > MappedFile::GetModifiedTime(path))
+        {
+            MeshFile file;
+            if(file.Open(cachePath.c_str()) && file.IsCookedWith(optimize, quantization))
+            {
+                LoadFromMeshFile(file);
+#ifdef NMGFX_PRINT_MESSAGES
+                printf("Loaded Mesh File %s, Vertex Count: %i, Index Count: %i\n", cachePath.c_str(), (int)file.GetHeader().vertexCount, (int)file.GetHeader().indexCount);
+#endif
+                return;
+            }
+#ifdef NMGFX_PRINT_MESSAGES
+            printf("Mesh file %s is invalid or was cooked with other settings, loading %s\n", cachePath.c_str(), path);
+#endif
+        }
+
+        Create();
+
+        std::vector<float> vertexData;
+        std::vector<uint32_t> indexData;
+        if(!ParseObjParallel(path, vertexData, indexData))
+        {
+#ifdef NMGFX_PRINT_MESSAGES
+            printf("Failed to load model: %s\n", path);
+#endif
+            return;
+        }
+
+#ifdef NMGFX_PRINT_MESSAGES
+        MeshOptimizeStats stats = OptimizeMesh(vertexData, 8, indexData, optimize);
+#else
+        OptimizeMesh(vertexData, 8, indexData, optimize);
+#endif
+        CalculateBounds(vertexData, 8, _boundsMin, _boundsMax);
 
         ResetAttributes();
-        SetModelData(vertexData);
-        SetIndexData(indexData);
-        SetAttribute(0, AttributeType::VEC3);
-        SetAttribute(1, AttributeType::VEC3);
-        SetAttribute(2, AttributeType::VEC2);
+        if(quantization == VertexQuantization::NONE)
+        {
+            SetModelData(vertexData);
+            SetAttribute(0, AttributeType::VEC3);
+            SetAttribute(1, AttributeType::VEC3);
+            SetAttribute(2, AttributeType::VEC2);
+        }
+        else
+        {
+            std::vector<uint8_t> packed;
+            std::vector<VertexAttribute> attributes;
+            QuantizeObjVertices(vertexData, quantization, packed, attributes);
+            SetModelData(packed.data(), packed.size());
+            for(const VertexAttribute& attribute : attributes)
+                SetAttribute(attribute.slot, attribute.type);
+        }
+        if (vertexData.size() / 8 <= 0xFFFF)
+            SetIndexData(std::vector<uint16_t>(indexData.begin(), indexData.end()));
+        else
+            SetIndexData(indexData);
         UploadAttributes();
 
 #ifdef NMGFX_PRINT_MESSAGES
-        printf("Loaded Model %s, Vertex Count: %i\n",path, (int)(vertexData.size() / 8));
+        uint32_t stride = _vao2d._attributeSizeInBytes;
+        printf("Loaded Model %s, Vertex Count: %i, Index Count: %i, Vertex Size: %i bytes\n",path, (int)(vertexData.size() / 8), (int)indexData.size(), (int)stride);
+        printf("  ACMR: %.3f -> %.3f\n", stats.acmrBefore, stats.acmrAfter);
 #endif
+    }
 
-        return;
-    };
+    bool Model::LoadFromMeshFile(const char* path)
+    {
+        MeshFile file;
+        if(!file.Open(path))
+        {
+#ifdef NMGFX_PRINT_MESSAGES
+            printf("Invalid mesh file: %s\n", path);
+#endif
+            return false;
+        }
+
+        LoadFromMeshFile(file);
+
+#ifdef NMGFX_PRINT_MESSAGES
+        printf("Loaded Mesh File %s, Vertex Count: %i, Index Count: %i\n", path, (int)file.GetHeader().vertexCount, (int)file.GetHeader().indexCount);
+#endif
+        return true;
+    }
+
+    void Model::LoadFromMeshFile(const MeshFile& file)
+    {
+        const MeshFileHeader& header = file.GetHeader();
+
+        Create();
+        ResetAttributes();
+        SetModelData(file.GetVertexData(), (uint32_t)header.vertexSize);
+        SetIndexData(file.GetIndexData(), header.indexCount, (IndexType)header.indexType);
+        for(uint32_t i = 0; i < header.attributeCount; i++)
+            SetAttribute(file.GetAttributes()[i].slot, (AttributeType)file.GetAttributes()[i].type);
+        UploadAttributes();
+
+        _boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+        _boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    }
 
 
     void Model::Create()
@@ -123,21 +364,34 @@ namespace nmGfx
         _ebo2d.Create(BufferType::INDEX_BUFFER);
     }
 
+    void Model::SetIndexData(const std::vector<uint16_t>& data)
+    {
+        SetIndexData(data.data(), data.size(), IndexType::UINT16);
+    }
     void Model::SetIndexData(const std::vector<uint32_t>& data)
     {
-        _indexCount = data.size();
+        SetIndexData(data.data(), data.size(), IndexType::UINT32);
+    }
+    void Model::SetIndexData(const void* data, uint32_t count, IndexType type)
+    {
+        _indexCount = count;
+        _indexType = type;
 
         _vao2d.Use();
         _ebo2d.Use();
-        _ebo2d.BufferData(data.data(), data.size() * sizeof(uint32_t), BufferUsage::STATIC_DRAW);
+        _ebo2d.BufferData(data, count * (type == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)), BufferUsage::STATIC_DRAW);
         VertexArray::Unbind();
     }
     void Model::SetModelData(const std::vector<float>& data)
     {
-        _vbodata_size = data.size();
+        SetModelData(data.data(), data.size() * sizeof(float));
+    }
+    void Model::SetModelData(const void* data, uint32_t size)
+    {
+        _vbodata_size = size;
         _vao2d.Use();
         _vbo2d.Use();
-        _vbo2d.BufferData(data.data(), data.size() * sizeof(float), BufferUsage::STATIC_DRAW);
+        _vbo2d.BufferData(data, size, BufferUsage::STATIC_DRAW);
         VertexArray::Unbind();
     }
     void Model::ResetAttributes()
@@ -145,6 +399,7 @@ namespace nmGfx
         _vao2d.Use();
         _vao2d.ResetAttributes();
         _attributes.clear();
+        _instanceBuffer = nullptr;
         VertexArray::Unbind();
     }
     void Model::SetAttribute(uint32_t slot, AttributeType type)
@@ -161,13 +416,28 @@ namespace nmGfx
     }
 
 
+    static GLenum GetGLIndexType(IndexType type)
+    {
+        return type == IndexType::UINT16 ? GL_UNSIGNED_SHORT
+             : type == IndexType::UINT32 ? GL_UNSIGNED_INT
+             : GL_NONE;
+    }
+
     void Model::Draw() const
     {
         _vao2d.Use();
         if(_indexCount > 0)
-            glDrawElements(GL_TRIANGLES, _indexCount, GL_UNSIGNED_INT, nullptr);
+            glDrawElements(GL_TRIANGLES, _indexCount, GetGLIndexType(_indexType), nullptr);
         else if(_vao2d._attributeSizeInBytes > 0)
             glDrawArrays(GL_TRIANGLES, 0, _vbodata_size / _vao2d._attributeSizeInBytes);
-        VertexArray::Unbind();
+    }
+
+    void Model::DrawInstanced(uint32_t instanceCount) const
+    {
+        _vao2d.Use();
+        if(_indexCount > 0)
+            glDrawElementsInstanced(GL_TRIANGLES, _indexCount, GetGLIndexType(_indexType), nullptr, instanceCount);
+        else if(_vao2d._attributeSizeInBytes > 0)
+            glDrawArraysInstanced(GL_TRIANGLES, 0, _vbodata_size / _vao2d._attributeSizeInBytes, instanceCount);
     }
 } // namespace nmGfx
@@ -3,11 +3,13 @@
 #pragma once
 
 #include <stdint.h>
+#include "glm/glm.hpp"
 #include <vector>
 #include <unordered_map>
 
 #include "Core/GL/nm_Buffer.hpp"
 #include "nm_VertexArray.hpp"
+#include "Core/nm_MeshOptimizer.hpp"
 
 namespace nmGfx
 {
@@ -18,12 +20,98 @@ namespace nmGfx
 		VEC2,
 		VEC3,
         VEC4,
+        INT,
+        MAT4, // takes 4 consecutive slots, one per column
+
+        // compact formats, all read as float vectors in shaders
+        HALF2,
+        HALF4,
+        INT_2_10_10_10_REV, // signed normalized xyz + 2 bit w, for normals
+        UNORM8x4,           // colors
+        UNORM16x2,          // uvs in [0, 1]
 	};
 
+    struct VertexAttribute
+    {
+        uint32_t slot;
+        AttributeType type;
+    };
+
+    // Bytes attribute takes in a vertex, 0 for NONE and unknown types
+    uint32_t GetAttributeSize(AttributeType type);
+
+    enum class VertexQuantization
+    {
+        // vec3 pos, vec3 normal, vec2 uv, 32 bytes
+        NONE = 0,
+        // vec3 pos, packed normal, unorm16 uv (half2 if uvs repeat), 20 bytes
+        COMPACT,
+        // half4 pos, packed normal, unorm16 uv (half2 if uvs repeat), 16 bytes. Positions lose precision far from origin
+        HALF,
+    };
+
+    enum class IndexType
+    {
+        UINT16 = 0,
+        UINT32,
+    };
+
+    /**
+     * @brief Loads obj file with tinyobj as deduplicated vertices (vec3 pos, vec3 normal, vec2 uv) and triangle list, no gl calls
+     *
+     * Reference path, loaders use ParseObjParallel which produces the same output.
+     * @param path
+     * @param vertexData
+     * @param indexData
+     * @return false if file can't be parsed
+     */
+    bool LoadObjMesh(const char* path, std::vector<float>& vertexData, std::vector<uint32_t>& indexData);
+
+    /**
+     * @brief Packs vertices in obj layout (vec3 pos, vec3 normal, vec2 uv) into compact attribute formats
+     *
+     * @param vertexData
+     * @param quantization
+     * @param packed interleaved output
+     * @param attributes layout of output, slots 0/1/2 like unpacked layout
+     * @return uint32_t output stride in bytes
+     */
+    uint32_t QuantizeObjVertices(const std::vector<float>& vertexData, VertexQuantization quantization, std::vector<uint8_t>& packed, std::vector<VertexAttribute>& attributes);
+
+    /**
+     * @brief Axis aligned bounds of positions, first 3 floats of each vertex
+     *
+     */
+    void CalculateBounds(const std::vector<float>& vertexData, uint32_t stride, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+    class MeshFile;
+
     class Model
     {
         public:
-            void LoadFromFile(const char* path);
+            /**
+             * @brief Loads obj file, vertices are deduplicated and optimized for vertex cache before upload
+             *
+             * If mesh file cooked with MeshFile::Cook exists next to it (path + ".nmesh"), is newer and was cooked
+             * with the same optimize and quantization settings, that is loaded instead.
+             *
+             * @param path
+             * @param optimize passes to run on loaded mesh, see nm_MeshOptimizer.hpp
+             * @param quantization vertex format to pack into
+             */
+            void LoadFromFile(const char* path, const MeshOptimizeSettings& optimize = MeshOptimizeSettings(), VertexQuantization quantization = VertexQuantization::NONE);
+            /**
+             * @brief Loads mesh file written by MeshFile, blobs are uploaded straight from mapped file
+             *
+             * @param path
+             * @return false if file is missing or invalid
+             */
+            bool LoadFromMeshFile(const char* path);
+            // Uploads mesh file that is already open
+            void LoadFromMeshFile(const MeshFile& file);
+
+            inline const glm::vec3& GetBoundsMin() const { return _boundsMin; }
+            inline const glm::vec3& GetBoundsMax() const { return _boundsMax; }
 
 
 
@@ -31,12 +119,16 @@ namespace nmGfx
             void Create();
 
             void SetModelData(const std::vector<float>& data);
+            void SetModelData(const void* data, uint32_t size);
             void SetIndexData(const std::vector<uint32_t>& data);
+            void SetIndexData(const std::vector<uint16_t>& data);
+            void SetIndexData(const void* data, uint32_t count, IndexType type);
             void ResetAttributes();
             void SetAttribute(uint32_t slot, AttributeType type);
             void UploadAttributes();
             
             void Draw() const;
+            void DrawInstanced(uint32_t instanceCount) const;
         protected:
             friend class Renderer;
 
@@ -46,7 +138,13 @@ namespace nmGfx
 
             std::unordered_map<uint32_t, Buffer> _attributes;
             uint32_t _indexCount = 0;
-            uint32_t _vbodata_size = 0;
+            IndexType _indexType = IndexType::UINT32;
+            uint32_t _vbodata_size = 0; // bytes
+            glm::vec3 _boundsMin{0.f, 0.f, 0.f};
+            glm::vec3 _boundsMax{0.f, 0.f, 0.f};
+
+            // instance buffer whose attributes are bound to _vao2d, set up by Renderer on first instanced draw
+            const Buffer* _instanceBuffer = nullptr;
     };
 } // namespace nmGfx
 
@@ -0,0 +1,89 @@
+#include "nm_PickReader.hpp"
+
+#include "glad/glad.h"
+#include "nm_StateCache.hpp"
+
+namespace nmGfx
+{
+    PickReader::~PickReader()
+    {
+        StateCache& stateCache = StateCache::Get();
+        for(Request& request : _requests)
+        {
+            glDeleteSync((GLsync)request.fence);
+            stateCache.OnBufferDeleted(request.buffer);
+            glDeleteBuffers(1, &request.buffer);
+        }
+        for(unsigned int buffer : _freeBuffers)
+        {
+            stateCache.OnBufferDeleted(buffer);
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+
+    void PickReader::ReadAsync(unsigned int attachment, int x, int y, int width, int height, ReadCallback callback)
+    {
+        if(width <= 0 || height <= 0)
+            return;
+
+        size_t size = (size_t)width * height * sizeof(int);
+
+        Request request;
+        if(!_freeBuffers.empty())
+        {
+            request.buffer = _freeBuffers.back();
+            _freeBuffers.pop_back();
+        }
+        else
+            glGenBuffers(1, &request.buffer);
+
+        StateCache& stateCache = StateCache::Get();
+        stateCache.BindBuffer(GL_PIXEL_PACK_BUFFER, request.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+
+        glReadBuffer(attachment);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(x, y, width, height, GL_RED_INTEGER, GL_INT, nullptr);
+        stateCache.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        request.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        request.width = width;
+        request.height = height;
+        request.callback = std::move(callback);
+        _requests.push_back(std::move(request));
+    }
+
+    void PickReader::Update(bool wait /*= false*/)
+    {
+        StateCache& stateCache = StateCache::Get();
+        while(!_requests.empty())
+        {
+            Request& request = _requests.front();
+            GLsync fence = (GLsync)request.fence;
+
+            // flush on wait so fence is guaranteed to be reached
+            GLenum status = glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+            if(status == GL_TIMEOUT_EXPIRED)
+                break;
+            glDeleteSync(fence);
+
+            size_t size = (size_t)request.width * request.height * sizeof(int);
+            stateCache.BindBuffer(GL_PIXEL_PACK_BUFFER, request.buffer);
+            const int* ids = status == GL_WAIT_FAILED ? nullptr : (const int*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+            // callback may queue new reads, so request is taken out first
+            Request finished = std::move(request);
+            _requests.pop_front();
+
+            if(ids != nullptr)
+            {
+                finished.callback(ids, finished.width, finished.height);
+                stateCache.BindBuffer(GL_PIXEL_PACK_BUFFER, finished.buffer);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            stateCache.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            _freeBuffers.push_back(finished.buffer);
+        }
+    }
+} // namespace nmGfx
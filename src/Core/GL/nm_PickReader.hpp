@@ -0,0 +1,66 @@
+#ifndef __NM_GFX_PICK_READER_HPP__
+#define __NM_GFX_PICK_READER_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <functional>
+
+namespace nmGfx
+{
+    /**
+     * @brief Reads integer draw id attachments into pixel buffer objects without stalling
+     *
+     * Each read is copied into its own buffer and fenced, results are handed out by Update once
+     * gpu has passed the fence, usually one or two frames later. Must be used on gl thread.
+     */
+    class PickReader
+    {
+        public:
+            // ids are row by row from bottom left, width * height of them
+            using ReadCallback = std::function<void(const int* ids, int width, int height)>;
+
+            PickReader() = default;
+            ~PickReader();
+            PickReader(const PickReader&) = delete;
+            PickReader& operator=(const PickReader&) = delete;
+
+            /**
+             * @brief Queues read of region of color attachment of currently bound framebuffer
+             *
+             * @param attachment GL_COLOR_ATTACHMENTi, must be an integer attachment
+             * @param x
+             * @param y
+             * @param width
+             * @param height
+             * @param callback called from Update when data is available, dropped if read fails
+             */
+            void ReadAsync(unsigned int attachment, int x, int y, int width, int height, ReadCallback callback);
+
+            /**
+             * @brief Calls callbacks of finished reads, in the order they were queued
+             *
+             * @param wait blocks until every queued read is finished
+             */
+            void Update(bool wait = false);
+
+            inline uint32_t GetPendingCount() const { return (uint32_t)_requests.size(); }
+
+        private:
+            struct Request
+            {
+                unsigned int buffer;
+                void* fence; // GLsync
+                int width;
+                int height;
+                ReadCallback callback;
+            };
+
+            std::deque<Request> _requests;
+            std::vector<unsigned int> _freeBuffers; // resized by every read, hover picks keep reusing them
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_PICK_READER_HPP__
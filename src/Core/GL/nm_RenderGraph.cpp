@@ -0,0 +1,292 @@
+#include "nm_RenderGraph.hpp"
+#include <stdio.h>
+#include "glad/glad.h"
+#include "nm_StateCache.hpp"
+
+namespace nmGfx
+{
+    RenderTargetHandle RenderGraph::Builder::Create(const std::string& name, const FramebufferDesc& desc, const glm::vec4& clearColor /*= glm::vec4(0.f)*/)
+    {
+        Target target;
+        target.name = name;
+        target.desc = desc;
+        target.clearColor = clearColor;
+        _graph._targets.push_back(std::move(target));
+        return (RenderTargetHandle)_graph._targets.size() - 1;
+    }
+
+    void RenderGraph::Builder::Read(RenderTargetHandle target)
+    {
+        if(target >= _graph._targets.size())
+        {
+            _graph._valid = false;
+            return;
+        }
+        _graph._passes[_pass].reads.push_back(target);
+    }
+
+    void RenderGraph::Builder::Write(RenderTargetHandle target, bool overwrites /*= false*/)
+    {
+        if(target >= _graph._targets.size())
+        {
+            _graph._valid = false;
+            return;
+        }
+        _graph._passes[_pass].writes.push_back({ target, overwrites, LoadOp::LOAD });
+    }
+
+    void RenderGraph::Builder::SetSideEffect()
+    {
+        _graph._passes[_pass].sideEffect = true;
+    }
+
+
+    RenderTargetHandle RenderGraph::Import(const std::string& name, Framebuffer& framebuffer, LoadOp load /*= LoadOp::LOAD*/, const glm::vec4& clearColor /*= glm::vec4(0.f)*/)
+    {
+        Target target;
+        target.name = name;
+        target.desc = framebuffer.GetDesc();
+        target.clearColor = clearColor;
+        target.framebuffer = &framebuffer;
+        target.imported = true;
+        target.importLoad = load;
+        _targets.push_back(std::move(target));
+        _compiled = false;
+        return (RenderTargetHandle)_targets.size() - 1;
+    }
+
+    void RenderGraph::AddPass(const std::string& name, const SetupFunc& setup, ExecuteFunc execute)
+    {
+        Pass pass;
+        pass.name = name;
+        pass.execute = std::move(execute);
+        _passes.push_back(std::move(pass));
+
+        Builder builder(*this, (uint32_t)_passes.size() - 1);
+        setup(builder);
+        _compiled = false;
+    }
+
+    bool RenderGraph::Compile()
+    {
+        _compiled = true;
+        _stats = Stats{};
+        _stats.passes = (uint32_t)_passes.size();
+        if(!_valid)
+            return false;
+
+        // reference counts: passes count targets they write, targets count passes reading them
+        for(Target& target : _targets)
+        {
+            target.writers.clear();
+            target.readCount = target.imported ? 1 : 0; // imported targets are read after the graph
+            target.used = target.written = false;
+        }
+        for(uint32_t i = 0; i < _passes.size(); i++)
+        {
+            Pass& pass = _passes[i];
+            pass.culled = false;
+            pass.writeCount = pass.sideEffect ? 1 : 0;
+            for(const TargetWrite& write : pass.writes)
+            {
+                _targets[write.target].writers.push_back(i);
+                pass.writeCount++;
+            }
+            for(RenderTargetHandle read : pass.reads)
+                _targets[read].readCount++;
+        }
+
+        // passes without outputs go first, then flood from targets nobody reads back to passes producing them
+        std::vector<RenderTargetHandle> unread;
+        for(Pass& pass : _passes)
+        {
+            if(pass.writeCount > 0)
+                continue;
+            pass.culled = true;
+            _stats.culledPasses++;
+            for(RenderTargetHandle read : pass.reads)
+                _targets[read].readCount--;
+        }
+        for(RenderTargetHandle i = 0; i < _targets.size(); i++)
+        {
+            if(_targets[i].readCount == 0)
+                unread.push_back(i);
+        }
+        while(!unread.empty())
+        {
+            Target& target = _targets[unread.back()];
+            unread.pop_back();
+            for(uint32_t writer : target.writers)
+            {
+                Pass& pass = _passes[writer];
+                if(pass.culled || --pass.writeCount > 0)
+                    continue;
+                pass.culled = true;
+                _stats.culledPasses++;
+                for(RenderTargetHandle read : pass.reads)
+                {
+                    if(--_targets[read].readCount == 0)
+                        unread.push_back(read);
+                }
+            }
+        }
+
+        // lifetimes and load ops from passes that are left
+        for(uint32_t i = 0; i < _passes.size(); i++)
+        {
+            Pass& pass = _passes[i];
+            if(pass.culled)
+                continue;
+
+            for(RenderTargetHandle read : pass.reads)
+            {
+                Target& target = _targets[read];
+                if(!target.used)
+                    target.firstPass = i;
+                target.lastPass = i;
+                target.used = true;
+            }
+            for(TargetWrite& write : pass.writes)
+            {
+                Target& target = _targets[write.target];
+                if(!target.used)
+                    target.firstPass = i;
+                target.lastPass = i;
+                target.used = true;
+
+                if(target.written)
+                    write.load = LoadOp::LOAD;
+                else if(target.imported)
+                    write.load = target.importLoad;
+                else
+                    write.load = write.overwrites ? LoadOp::DONT_CARE : LoadOp::CLEAR;
+                target.written = true;
+            }
+        }
+
+        for(const Target& target : _targets)
+        {
+            if(!target.imported && target.used)
+                _stats.transientTargets++;
+        }
+        return true;
+    }
+
+    void RenderGraph::Clear(Target& target)
+    {
+        Framebuffer& framebuffer = *target.framebuffer;
+        const FramebufferDesc& desc = framebuffer.GetDesc();
+        StateCache& stateCache = StateCache::Get();
+        framebuffer.Use();
+        stateCache.SetEnabled(GL_SCISSOR_TEST, false);
+
+        for(uint32_t i = 0; i < desc.colorCount; i++)
+        {
+            if(desc.colors[i] == AttachmentFormat::NONE)
+                continue;
+            if(desc.colors[i] == AttachmentFormat::R32I)
+            {
+                GLint value[4] = { 0, 0, 0, 0 };
+                glClearBufferiv(GL_COLOR, i, value);
+            }
+            else
+                glClearBufferfv(GL_COLOR, i, &target.clearColor.x);
+        }
+        if(desc.depth != DepthFormat::NONE)
+            glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.f, 0);
+
+        _stats.clears++;
+    }
+
+    void RenderGraph::Execute()
+    {
+        if(!_compiled)
+            Compile();
+        if(!_valid)
+        {
+#ifdef NMGFX_PRINT_MESSAGES
+            printf("Render graph uses unknown target, skipped\n");
+#endif
+            Reset();
+            return;
+        }
+
+        std::vector<Framebuffer*> acquired;
+        for(uint32_t i = 0; i < _passes.size(); i++)
+        {
+            Pass& pass = _passes[i];
+            if(pass.culled)
+                continue;
+
+            // transient targets start living here
+            for(Target& target : _targets)
+            {
+                if(target.imported || !target.used || target.firstPass != i)
+                    continue;
+                target.framebuffer = &_pool.Acquire(target.desc);
+                bool known = false;
+                for(Framebuffer* framebuffer : acquired)
+                    known = known || framebuffer == target.framebuffer;
+                if(!known)
+                    acquired.push_back(target.framebuffer);
+            }
+
+            for(const TargetWrite& write : pass.writes)
+            {
+                if(write.load == LoadOp::CLEAR)
+                    Clear(_targets[write.target]);
+            }
+            if(!pass.writes.empty())
+                _targets[pass.writes[0].target].framebuffer->Use();
+
+            pass.execute(*this);
+
+            // and go back to the pool after their last pass, to be acquired by later targets
+            for(Target& target : _targets)
+            {
+                if(!target.imported && target.used && target.lastPass == i)
+                {
+                    _pool.Release(*target.framebuffer);
+                    target.framebuffer = nullptr;
+                }
+            }
+        }
+        _stats.acquiredTargets = (uint32_t)acquired.size();
+
+        Reset();
+    }
+
+    void RenderGraph::Reset()
+    {
+        _targets.clear();
+        _passes.clear();
+        _compiled = false;
+        _valid = true;
+    }
+
+    Framebuffer& RenderGraph::GetFramebuffer(RenderTargetHandle target)
+    {
+        return *_targets[target].framebuffer;
+    }
+
+    unsigned int RenderGraph::GetTexture(RenderTargetHandle target, uint32_t attachment /*= 0*/)
+    {
+        Framebuffer* framebuffer = target < _targets.size() ? _targets[target].framebuffer : nullptr;
+        return framebuffer != nullptr ? framebuffer->GetColorID(attachment) : 0;
+    }
+
+    bool RenderGraph::IsWritten(RenderTargetHandle target) const
+    {
+        return target < _targets.size() && _targets[target].written;
+    }
+
+    bool RenderGraph::IsCulled(const std::string& pass) const
+    {
+        for(const Pass& p : _passes)
+        {
+            if(p.name == pass)
+                return p.culled;
+        }
+        return false;
+    }
+} // namespace nmGfx
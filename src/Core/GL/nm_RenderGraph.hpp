@@ -0,0 +1,185 @@
+#ifndef __NM_GFX_RENDER_GRAPH_HPP__
+#define __NM_GFX_RENDER_GRAPH_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "nm_Framebuffer.hpp"
+#include "nm_RenderTargetPool.hpp"
+
+namespace nmGfx
+{
+    using RenderTargetHandle = uint32_t;
+    static const RenderTargetHandle INVALID_RENDER_TARGET = 0xFFFFFFFF;
+
+    // What happens to contents of a target when a pass starts writing it
+    enum class LoadOp
+    {
+        CLEAR = 0,
+        LOAD,
+        DONT_CARE, // pass overwrites every pixel
+    };
+
+    /**
+     * @brief Runs passes of a frame in the order they were added, skipping passes nobody needs
+     *
+     * Passes declare the targets they read and write in setup. On Compile, passes whose writes
+     * are never read are culled, unless they write an imported target or have side effects.
+     * Transient targets are acquired from the pool right before their first pass and released
+     * after their last one, so targets with equal desc and disjoint lifetimes share memory.
+     * The first pass left writing a target clears it, later ones load it. GL orders
+     * framebuffer writes before later sampling of the same texture, no barriers are needed.
+     *
+     * Graph is rebuilt every frame: add passes, Execute, the graph is empty again.
+     */
+    class RenderGraph
+    {
+        public:
+            class Builder
+            {
+                public:
+                    /**
+                     * @brief Declares transient target, it only exists while passes use it
+                     *
+                     * @param name
+                     * @param desc
+                     * @param clearColor used for every color attachment when target is cleared
+                     * @return RenderTargetHandle
+                     */
+                    RenderTargetHandle Create(const std::string& name, const FramebufferDesc& desc, const glm::vec4& clearColor = glm::vec4(0.f));
+                    // Pass samples target
+                    void Read(RenderTargetHandle target);
+                    /**
+                     * @brief Pass renders into target. First target written is bound when the pass executes
+                     *
+                     * @param target
+                     * @param overwrites pass covers every pixel, contents don't need to be cleared first
+                     */
+                    void Write(RenderTargetHandle target, bool overwrites = false);
+                    // Pass is never culled, for passes drawing to window or reading back
+                    void SetSideEffect();
+
+                private:
+                    Builder(RenderGraph& graph, uint32_t pass) : _graph(graph), _pass(pass) {}
+
+                    RenderGraph& _graph;
+                    uint32_t _pass;
+
+                    friend class RenderGraph;
+            };
+
+            using SetupFunc = std::function<void(Builder& builder)>;
+            using ExecuteFunc = std::function<void(RenderGraph& graph)>;
+
+            struct Stats
+            {
+                uint32_t passes = 0;
+                uint32_t culledPasses = 0;
+                uint32_t clears = 0;
+                uint32_t transientTargets = 0;
+                uint32_t acquiredTargets = 0; // distinct framebuffers transient targets ended up in
+            };
+
+        public:
+            explicit RenderGraph(RenderTargetPool& pool) : _pool(pool) {}
+            RenderGraph(const RenderGraph&) = delete;
+            RenderGraph& operator=(const RenderGraph&) = delete;
+
+            /**
+             * @brief Makes framebuffer owned elsewhere usable by passes. Passes writing it are never culled
+             *
+             * @param name
+             * @param framebuffer must outlive Execute
+             * @param load what the first pass writing it does with previous contents
+             * @param clearColor
+             * @return RenderTargetHandle
+             */
+            RenderTargetHandle Import(const std::string& name, Framebuffer& framebuffer, LoadOp load = LoadOp::LOAD, const glm::vec4& clearColor = glm::vec4(0.f));
+
+            /**
+             * @brief Adds pass, setup is called right away
+             *
+             * @param name
+             * @param setup declares targets through builder
+             * @param execute called from Execute with first written target bound
+             */
+            void AddPass(const std::string& name, const SetupFunc& setup, ExecuteFunc execute);
+
+            /**
+             * @brief Culls passes and works out target lifetimes and load ops. Called by Execute if needed
+             *
+             * @return false if a pass used a handle that doesn't exist
+             */
+            bool Compile();
+            // Runs passes that weren't culled and empties the graph
+            void Execute();
+            // Drops passes and targets without running them
+            void Reset();
+
+            // Framebuffer of target, only valid while passes execute
+            Framebuffer& GetFramebuffer(RenderTargetHandle target);
+            // Texture of color attachment of target, only valid while passes execute
+            unsigned int GetTexture(RenderTargetHandle target, uint32_t attachment = 0);
+
+            // After Compile until Execute returns, false if no pass left writes target
+            bool IsWritten(RenderTargetHandle target) const;
+            // After Compile until Execute returns, whether pass with name was culled
+            bool IsCulled(const std::string& pass) const;
+
+            inline const Stats& GetStats() const { return _stats; }
+
+        private:
+            struct Target
+            {
+                std::string name;
+                FramebufferDesc desc;
+                glm::vec4 clearColor;
+                Framebuffer* framebuffer = nullptr; // imported or acquired from pool
+                bool imported = false;
+                LoadOp importLoad = LoadOp::LOAD;
+
+                std::vector<uint32_t> writers;
+                uint32_t readCount = 0; // culling reference count
+                uint32_t firstPass = 0; // lifetime among passes left after culling
+                uint32_t lastPass = 0;
+                bool used = false;
+                bool written = false;
+            };
+
+            struct TargetWrite
+            {
+                RenderTargetHandle target;
+                bool overwrites;
+                LoadOp load; // inferred on Compile
+            };
+
+            struct Pass
+            {
+                std::string name;
+                ExecuteFunc execute;
+                std::vector<RenderTargetHandle> reads;
+                std::vector<TargetWrite> writes;
+                bool sideEffect = false;
+                bool culled = false;
+                uint32_t writeCount = 0; // culling reference count
+            };
+
+            void Clear(Target& target);
+
+            RenderTargetPool& _pool;
+            std::vector<Target> _targets;
+            std::vector<Pass> _passes;
+            bool _compiled = false;
+            bool _valid = true;
+
+            Stats _stats;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_RENDER_GRAPH_HPP__
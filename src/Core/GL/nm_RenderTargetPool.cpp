@@ -0,0 +1,95 @@
+#include "nm_RenderTargetPool.hpp"
+#include <stdio.h>
+
+namespace nmGfx
+{
+    RenderTargetPool::~RenderTargetPool()
+    {
+        for(Entry& entry : _entries)
+            entry.framebuffer->Destroy();
+    }
+
+    Framebuffer& RenderTargetPool::Acquire(const FramebufferDesc& desc)
+    {
+        for(Entry& entry : _entries)
+        {
+            if(!entry.inUse && entry.framebuffer->GetDesc() == desc)
+            {
+                entry.inUse = true;
+                entry.lastUsedFrame = _frame;
+                return *entry.framebuffer;
+            }
+        }
+
+        Entry entry;
+        entry.framebuffer = std::make_unique<Framebuffer>();
+        entry.inUse = true;
+        entry.lastUsedFrame = _frame;
+        if(!entry.framebuffer->Create(desc))
+        {
+#ifdef NMGFX_PRINT_MESSAGES
+            printf("Failed creating render target %ix%i\n", desc.width, desc.height);
+#endif
+        }
+        _memoryUsage += entry.framebuffer->GetDesc().GetMemorySize();
+
+        _entries.push_back(std::move(entry));
+        return *_entries.back().framebuffer;
+    }
+
+    void RenderTargetPool::Release(Framebuffer& target)
+    {
+        for(Entry& entry : _entries)
+        {
+            if(entry.framebuffer.get() == &target)
+            {
+                entry.inUse = false;
+                entry.lastUsedFrame = _frame;
+                return;
+            }
+        }
+    }
+
+    void RenderTargetPool::Update(uint64_t frame)
+    {
+        _frame = frame;
+        for(size_t i = 0; i < _entries.size();)
+        {
+            Entry& entry = _entries[i];
+            if(!entry.inUse && entry.lastUsedFrame + _maxIdleFrames < frame)
+            {
+                _memoryUsage -= entry.framebuffer->GetDesc().GetMemorySize();
+                entry.framebuffer->Destroy();
+                _entries[i] = std::move(_entries.back());
+                _entries.pop_back();
+            }
+            else
+                i++;
+        }
+    }
+
+    void RenderTargetPool::Clear()
+    {
+        for(size_t i = 0; i < _entries.size();)
+        {
+            Entry& entry = _entries[i];
+            if(!entry.inUse)
+            {
+                _memoryUsage -= entry.framebuffer->GetDesc().GetMemorySize();
+                entry.framebuffer->Destroy();
+                _entries[i] = std::move(_entries.back());
+                _entries.pop_back();
+            }
+            else
+                i++;
+        }
+    }
+
+    size_t RenderTargetPool::GetInUseCount() const
+    {
+        size_t count = 0;
+        for(const Entry& entry : _entries)
+            count += entry.inUse ? 1 : 0;
+        return count;
+    }
+} // namespace nmGfx
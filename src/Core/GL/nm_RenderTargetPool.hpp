@@ -0,0 +1,72 @@
+#ifndef __NM_GFX_RENDER_TARGET_POOL_HPP__
+#define __NM_GFX_RENDER_TARGET_POOL_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "nm_Framebuffer.hpp"
+
+namespace nmGfx
+{
+    /**
+     * @brief Recycles transient framebuffers between passes
+     *
+     * A pass acquires a target, renders into it and releases it once the next pass has read it.
+     * Released targets are handed to the next Acquire with an equal desc, within the frame and
+     * across frames. Targets that stay released for a few frames are destroyed.
+     */
+    class RenderTargetPool
+    {
+        public:
+            RenderTargetPool() = default;
+            ~RenderTargetPool();
+            RenderTargetPool(const RenderTargetPool&) = delete;
+            RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+            /**
+             * @brief Returns released target with equal desc or creates one
+             *
+             * Contents are undefined, clear before drawing. Reference stays valid until target is destroyed.
+             *
+             * @param desc
+             * @return Framebuffer&
+             */
+            Framebuffer& Acquire(const FramebufferDesc& desc);
+            // Hands target back to the pool, it may be returned by the next Acquire
+            void Release(Framebuffer& target);
+
+            /**
+             * @brief Destroys targets released for more than max idle frames. Call once per frame
+             *
+             * @param frame current frame
+             */
+            void Update(uint64_t frame);
+            // Destroys released targets
+            void Clear();
+
+            inline void SetMaxIdleFrames(uint32_t frames) { _maxIdleFrames = frames; }
+            inline uint32_t GetMaxIdleFrames() const { return _maxIdleFrames; }
+            // Bytes of gpu memory of pooled targets, in use or not
+            inline uint64_t GetMemoryUsage() const { return _memoryUsage; }
+            inline size_t GetCount() const { return _entries.size(); }
+            size_t GetInUseCount() const;
+
+        private:
+            struct Entry
+            {
+                std::unique_ptr<Framebuffer> framebuffer; // pointer keeps references stable when entries move
+                uint64_t lastUsedFrame = 0;
+                bool inUse = false;
+            };
+
+            std::vector<Entry> _entries;
+            uint64_t _frame = 0;
+            uint32_t _maxIdleFrames = 3;
+            uint64_t _memoryUsage = 0;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_RENDER_TARGET_POOL_HPP__
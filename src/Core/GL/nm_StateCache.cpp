@@ -0,0 +1,226 @@
+#include "nm_StateCache.hpp"
+#include "glad/glad.h"
+
+namespace nmGfx
+{
+    StateCache& StateCache::Get()
+    {
+        static thread_local StateCache cache;
+        return cache;
+    }
+
+    StateCache::StateCache()
+    {
+        Invalidate();
+    }
+
+    void StateCache::Invalidate()
+    {
+        _program = UNKNOWN;
+        _vertexArray = UNKNOWN;
+        _arrayBuffer = UNKNOWN;
+        _elementBuffer = UNKNOWN;
+        _framebuffer = UNKNOWN;
+        _viewport[0] = _viewport[1] = _viewport[2] = _viewport[3] = -1;
+
+        _activeSlot = -1;
+        for(uint32_t i = 0; i < MAX_TEXTURE_SLOTS; i++)
+        {
+            _textures2D[i] = UNKNOWN;
+            _texturesCube[i] = UNKNOWN;
+        }
+
+        _capabilities.clear();
+    }
+
+    void StateCache::UseProgram(unsigned int id)
+    {
+        if(_program == id)
+        {
+            _stats.skipped++;
+            return;
+        }
+        _program = id;
+        _stats.issued++;
+        glUseProgram(id);
+    }
+
+    void StateCache::BindVertexArray(unsigned int id)
+    {
+        if(_vertexArray == id)
+        {
+            _stats.skipped++;
+            return;
+        }
+        _vertexArray = id;
+        _elementBuffer = UNKNOWN;
+        _stats.issued++;
+        glBindVertexArray(id);
+    }
+
+    void StateCache::BindBuffer(unsigned int target, unsigned int id)
+    {
+        unsigned int* cached = target == GL_ARRAY_BUFFER ? &_arrayBuffer
+                             : target == GL_ELEMENT_ARRAY_BUFFER ? &_elementBuffer
+                             : nullptr;
+        if(cached != nullptr)
+        {
+            if(*cached == id)
+            {
+                _stats.skipped++;
+                return;
+            }
+            *cached = id;
+        }
+        _stats.issued++;
+        glBindBuffer(target, id);
+    }
+
+    void StateCache::BindFramebuffer(unsigned int id)
+    {
+        if(_framebuffer == id)
+        {
+            _stats.skipped++;
+            return;
+        }
+        _framebuffer = id;
+        _stats.issued++;
+        glBindFramebuffer(GL_FRAMEBUFFER, id);
+    }
+
+    void StateCache::Viewport(int x, int y, int width, int height)
+    {
+        if(_viewport[0] == x && _viewport[1] == y && _viewport[2] == width && _viewport[3] == height)
+        {
+            _stats.skipped++;
+            return;
+        }
+        _viewport[0] = x;
+        _viewport[1] = y;
+        _viewport[2] = width;
+        _viewport[3] = height;
+        _stats.issued++;
+        glViewport(x, y, width, height);
+    }
+
+    void StateCache::ActiveTexture(int slot)
+    {
+        if(_activeSlot == slot)
+        {
+            _stats.skipped++;
+            return;
+        }
+        _activeSlot = slot;
+        _stats.issued++;
+        glActiveTexture(GL_TEXTURE0 + slot);
+    }
+
+    void StateCache::BindTexture(unsigned int target, unsigned int id)
+    {
+        unsigned int* cached = nullptr;
+        if(_activeSlot >= 0 && _activeSlot < (int)MAX_TEXTURE_SLOTS)
+        {
+            cached = target == GL_TEXTURE_2D ? &_textures2D[_activeSlot]
+                   : target == GL_TEXTURE_CUBE_MAP ? &_texturesCube[_activeSlot]
+                   : nullptr;
+        }
+        if(cached != nullptr)
+        {
+            if(*cached == id)
+            {
+                _stats.skipped++;
+                return;
+            }
+            *cached = id;
+        }
+        _stats.issued++;
+        glBindTexture(target, id);
+    }
+
+    void StateCache::BindTexture(unsigned int target, unsigned int id, int slot)
+    {
+        unsigned int* cached = nullptr;
+        if(slot >= 0 && slot < (int)MAX_TEXTURE_SLOTS)
+        {
+            cached = target == GL_TEXTURE_2D ? &_textures2D[slot]
+                   : target == GL_TEXTURE_CUBE_MAP ? &_texturesCube[slot]
+                   : nullptr;
+        }
+        if(cached != nullptr && *cached == id)
+        {
+            _stats.skipped++;
+            return;
+        }
+
+        ActiveTexture(slot);
+        BindTexture(target, id);
+    }
+
+    void StateCache::SetEnabled(unsigned int capability, bool enabled)
+    {
+        auto it = _capabilities.find(capability);
+        if(it != _capabilities.end() && it->second == enabled)
+        {
+            _stats.skipped++;
+            return;
+        }
+        _capabilities[capability] = enabled;
+        _stats.issued++;
+        if(enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    bool StateCache::IsEnabled(unsigned int capability)
+    {
+        auto it = _capabilities.find(capability);
+        if(it != _capabilities.end())
+            return it->second;
+
+        bool enabled = glIsEnabled(capability) == GL_TRUE;
+        _capabilities[capability] = enabled;
+        return enabled;
+    }
+
+
+    void StateCache::OnProgramDeleted(unsigned int id)
+    {
+        if(_program == id)
+            _program = UNKNOWN;
+    }
+
+    void StateCache::OnVertexArrayDeleted(unsigned int id)
+    {
+        if(_vertexArray == id)
+        {
+            _vertexArray = UNKNOWN;
+            _elementBuffer = UNKNOWN;
+        }
+    }
+
+    void StateCache::OnBufferDeleted(unsigned int id)
+    {
+        if(_arrayBuffer == id)
+            _arrayBuffer = UNKNOWN;
+        if(_elementBuffer == id)
+            _elementBuffer = UNKNOWN;
+    }
+
+    void StateCache::OnTextureDeleted(unsigned int id)
+    {
+        for(uint32_t i = 0; i < MAX_TEXTURE_SLOTS; i++)
+        {
+            if(_textures2D[i] == id)
+                _textures2D[i] = UNKNOWN;
+            if(_texturesCube[i] == id)
+                _texturesCube[i] = UNKNOWN;
+        }
+    }
+
+    void StateCache::OnFramebufferDeleted(unsigned int id)
+    {
+        if(_framebuffer == id)
+            _framebuffer = UNKNOWN;
+    }
+} // namespace nmGfx
@@ -0,0 +1,85 @@
+#ifndef __NM_GFX_STATE_CACHE_HPP__
+#define __NM_GFX_STATE_CACHE_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+
+namespace nmGfx
+{
+    /**
+     * @brief Tracks GL bindings of the current context and skips calls that would not change anything.
+     *
+     * Every GL wrapper (Shader, VertexArray, Buffer, Texture, Framebuffer) binds through this.
+     * Call Invalidate() after touching GL state directly so the next call is issued again.
+     */
+    class StateCache
+    {
+        public:
+            struct Stats
+            {
+                uint32_t issued = 0;
+                uint32_t skipped = 0;
+            };
+
+            static const uint32_t MAX_TEXTURE_SLOTS = 32;
+
+        public:
+            // renderer runs on a single context, so one cache per thread is one cache per context
+            static StateCache& Get();
+
+            void UseProgram(unsigned int id);
+            void BindVertexArray(unsigned int id);
+            void BindBuffer(unsigned int target, unsigned int id);
+            void BindFramebuffer(unsigned int id);
+            void Viewport(int x, int y, int width, int height);
+
+            void ActiveTexture(int slot);
+            // binds to currently active slot
+            void BindTexture(unsigned int target, unsigned int id);
+            void BindTexture(unsigned int target, unsigned int id, int slot);
+
+            void SetEnabled(unsigned int capability, bool enabled);
+            // queries gl once for capabilities that weren't set through the cache
+            bool IsEnabled(unsigned int capability);
+
+            // Forget bindings of deleted objects, GL may hand out the same name again
+            void OnProgramDeleted(unsigned int id);
+            void OnVertexArrayDeleted(unsigned int id);
+            void OnBufferDeleted(unsigned int id);
+            void OnTextureDeleted(unsigned int id);
+            void OnFramebufferDeleted(unsigned int id);
+
+            /**
+             * @brief Marks every cached value as unknown
+             *
+             */
+            void Invalidate();
+
+            inline const Stats& GetStats() const { return _stats; }
+            inline void ResetStats() { _stats = Stats{}; }
+
+        private:
+            StateCache();
+
+            static const unsigned int UNKNOWN = 0xFFFFFFFF;
+
+            unsigned int _program;
+            unsigned int _vertexArray;
+            unsigned int _arrayBuffer;
+            unsigned int _elementBuffer; // part of vertex array state
+            unsigned int _framebuffer;
+            int _viewport[4];
+
+            int _activeSlot;
+            unsigned int _textures2D[MAX_TEXTURE_SLOTS];
+            unsigned int _texturesCube[MAX_TEXTURE_SLOTS];
+
+            std::unordered_map<unsigned int, bool> _capabilities;
+
+            Stats _stats;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_STATE_CACHE_HPP__
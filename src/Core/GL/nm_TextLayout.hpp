@@ -0,0 +1,64 @@
+#ifndef __NM_GFX_TEXT_LAYOUT_HPP__
+#define __NM_GFX_TEXT_LAYOUT_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+
+#include "nm_Buffer.hpp"
+#include "nm_VertexArray.hpp"
+
+namespace nmGfx
+{
+    class Font;
+
+    /**
+     * @brief Positioned glyph quads of a string, uploaded once and drawn many times with Renderer::DrawTextLayout
+     *
+     * Built by Renderer::GetTextLayout. Font must outlive its layouts, layout is rebuilt automatically if font evicted glyphs.
+     */
+    class TextLayout
+    {
+        public:
+            TextLayout() = default;
+            TextLayout(const TextLayout&) = delete;
+            TextLayout& operator=(const TextLayout&) = delete;
+
+            inline glm::vec2 GetSize() const { return _size; }
+            // x0, y0, x1, y1 of all glyph quads
+            inline const glm::vec4& GetBounds() const { return _bounds; }
+            inline int GetLineCount() const { return _lines; }
+            inline const std::string& GetText() const { return _text; }
+            inline float GetScale() const { return _scale; }
+
+        private:
+            struct PageRange
+            {
+                unsigned int textureID;
+                uint32_t first;
+                uint32_t count;
+            };
+
+            Font* _font = nullptr;
+            uint64_t _fontId = 0;
+            uint64_t _atlasGeneration = 0;
+            std::string _text;
+            float _scale = 1.f;
+
+            glm::vec2 _size{0.f, 0.f};
+            glm::vec4 _bounds{0.f, 0.f, 0.f, 0.f};
+            int _lines = 0;
+
+            bool _uploaded = false;
+            VertexArray _vao;
+            Buffer _vbo;
+            std::vector<PageRange> _pages;
+
+            friend class Renderer;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_TEXT_LAYOUT_HPP__
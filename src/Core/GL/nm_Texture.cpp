@@ -2,6 +2,30 @@
 
 #include "glad/glad.h"
 #include "stb_image.h"
+#include "nm_StateCache.hpp"
+#include "Core/nm_CompressedImage.hpp"
+#include <stdlib.h>
+#include <string.h>
+
+// extension formats glad wasn't generated with
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
 
 namespace nmGfx
 {
@@ -20,29 +44,143 @@ namespace nmGfx
             : GL_NONE;
     }
 
+    static GLenum GetCompressedFormat(BlockFormat format, bool srgb)
+    {
+        return format == BlockFormat::BC1 ? (srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT)
+            : format == BlockFormat::BC3 ? (srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+            : format == BlockFormat::BC5 ? GL_COMPRESSED_RG_RGTC2
+            : format == BlockFormat::BC7 ? (srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM)
+            : GL_NONE;
+    }
+
+    // uncompressed textures are assumed to be stored as 4 bytes per pixel, mips add a third
+    static uint64_t CalculateMemorySize(int width, int height, bool mipmapped)
+    {
+        uint64_t size = (uint64_t)width * height * 4;
+        return mipmapped ? size + size / 3 : size;
+    }
+
+    PixelRetention Texture::s_DefaultRetention = PixelRetention::KEEP;
+    uint64_t Texture::s_CurrentFrame = 0;
+
     Texture::~Texture()
     {
-        
+        ReleasePixels();
+        DeleteTexture();
     }
 
-    void Texture::LoadFromData(unsigned char* data, int width, int height, int channels, TextureType type/* = TextureType::TEXTURE2D*/)
+    void Texture::DeleteTexture()
     {
-		if (_pixels != nullptr) {
-			stbi_image_free(_pixels);
-			_pixels = nullptr;
-		}
+        if(_id != 0 && !_borrowedID)
+        {
+            StateCache::Get().OnTextureDeleted(_id);
+            glDeleteTextures(1, &_id);
+        }
+        _id = 0;
+        _borrowedID = false;
+        _memorySize = 0;
+    }
+
+    void Texture::SetDefaultPixelRetention(PixelRetention retention)
+    {
+        s_DefaultRetention = retention;
+    }
+
+    unsigned char* Texture::GetPixels()
+    {
+        if(_pixels != nullptr || _pending || _borrowedID || _id == 0 || _type != TextureType::TEXTURE2D || _width <= 0 || _height <= 0)
+            return _pixels;
+
+        GLenum format = GetTextureFormat(_channels);
+        if(format == GL_NONE)
+            return nullptr;
+
+        // malloc so it can be freed with stbi_image_free like decoded pixels
+        _pixels = (unsigned char*)malloc((size_t)_width * _height * _channels);
+        if(_pixels == nullptr)
+            return nullptr;
+
+        StateCache::Get().BindTexture(GL_TEXTURE_2D, _id);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTexImage(GL_TEXTURE_2D, 0, format, GL_UNSIGNED_BYTE, _pixels);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        return _pixels;
+    }
+
+    const unsigned char* Texture::GetDownsampledPixels(int& width, int& height) const
+    {
+        width = _downsampledWidth;
+        height = _downsampledHeight;
+        return _downsampled.empty() ? nullptr : _downsampled.data();
+    }
+
+    void Texture::ReleasePixels()
+    {
+        if (_pixels != nullptr) {
+            stbi_image_free(_pixels);
+            _pixels = nullptr;
+        }
+    }
+
+    void Texture::RetainPixels()
+    {
+        _downsampled.clear();
+        _downsampled.shrink_to_fit();
+        _downsampledWidth = 0;
+        _downsampledHeight = 0;
+
+        if(_pixels == nullptr || _retention == PixelRetention::KEEP)
+            return;
+
+        if(_retention == PixelRetention::KEEP_DOWNSAMPLED)
+        {
+            // box filter by power of two factor
+            int factor = 1;
+            while(_width / factor > DOWNSAMPLED_SIZE || _height / factor > DOWNSAMPLED_SIZE)
+                factor *= 2;
+
+            _downsampledWidth = _width / factor > 0 ? _width / factor : 1;
+            _downsampledHeight = _height / factor > 0 ? _height / factor : 1;
+            _downsampled.resize((size_t)_downsampledWidth * _downsampledHeight * _channels);
+
+            for(int y = 0; y < _downsampledHeight; y++)
+            {
+                for(int x = 0; x < _downsampledWidth; x++)
+                {
+                    int x1 = (x + 1) * factor < _width ? (x + 1) * factor : _width;
+                    int y1 = (y + 1) * factor < _height ? (y + 1) * factor : _height;
+                    int count = (x1 - x * factor) * (y1 - y * factor);
+
+                    for(int c = 0; c < _channels; c++)
+                    {
+                        uint32_t sum = 0;
+                        for(int sy = y * factor; sy < y1; sy++)
+                            for(int sx = x * factor; sx < x1; sx++)
+                                sum += _pixels[((size_t)sy * _width + sx) * _channels + c];
+                        _downsampled[((size_t)y * _downsampledWidth + x) * _channels + c] = (unsigned char)((sum + count / 2) / count);
+                    }
+                }
+            }
+        }
+
+        ReleasePixels();
+    }
+
+    void Texture::LoadFromData(const unsigned char* data, int width, int height, int channels, TextureType type/* = TextureType::TEXTURE2D*/)
+    {
+		ReleasePixels();
 
 		_width = width;
 		_height = height;
 		_channels = channels;
-		_pixels = data;
 		_type = type;
 
 		if (data) {
 			// glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
+			DeleteTexture();
 			glGenTextures(1, &_id);
-			glBindTexture(GetTextureType(_type), _id);
+			StateCache::Get().BindTexture(GetTextureType(_type), _id);
 
 			glTexParameteri(GetTextureType(_type), GL_TEXTURE_WRAP_S, GL_REPEAT);
 			glTexParameteri(GetTextureType(_type), GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -51,6 +189,16 @@ namespace nmGfx
 
 			glTexImage2D(GetTextureType(_type), 0, GL_RGB, _width, _height, 0, GetTextureFormat(_channels), GL_UNSIGNED_BYTE, data);
             glGenerateMipmap(GetTextureType(_type));
+            _memorySize = CalculateMemorySize(_width, _height, true);
+
+            // caller keeps its memory, copy is made only if something is retained
+            if (_retention != PixelRetention::DROP) {
+                size_t size = (size_t)_width * _height * _channels;
+                _pixels = (unsigned char*)malloc(size);
+                if (_pixels != nullptr)
+                    memcpy(_pixels, data, size);
+            }
+            RetainPixels();
 		} else {
 #ifdef NMGFX_PRINT_MESSAGES
             printf("Error: Failed to load texture from pixel data.\n");
@@ -61,10 +209,7 @@ namespace nmGfx
 	void Texture::Load2DFromFile(const char *path) {
 		_type = TextureType::TEXTURE2D;
 
-		if (_pixels != nullptr) {
-			stbi_image_free(_pixels);
-			_pixels = nullptr;
-		}
+		ReleasePixels();
 
 		stbi_set_flip_vertically_on_load(true);
 		_pixels = stbi_load(path, &_width, &_height, &_channels, 0);
@@ -72,8 +217,9 @@ namespace nmGfx
 		if (_pixels) {
 			// glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
+			DeleteTexture();
 			glGenTextures(1, &_id);
-			glBindTexture(GetTextureType(_type), _id);
+			StateCache::Get().BindTexture(GetTextureType(_type), _id);
 
 			glTexParameteri(GetTextureType(_type), GL_TEXTURE_WRAP_S, GL_REPEAT);
 			glTexParameteri(GetTextureType(_type), GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -82,6 +228,8 @@ namespace nmGfx
 
 			glTexImage2D(GetTextureType(_type), 0, GL_RGBA, _width, _height, 0, GetTextureFormat(_channels), GL_UNSIGNED_BYTE, _pixels);
 			glGenerateMipmap(GetTextureType(_type));
+			_memorySize = CalculateMemorySize(_width, _height, true);
+			RetainPixels();
 		} else {
 #ifdef NMGFX_PRINT_MESSAGES
 			printf("Error: Failed to load texture: %s\n", path);
@@ -92,18 +240,16 @@ namespace nmGfx
 	bool Texture::Load2DFromMemory(const unsigned char *filedata, size_t size) {
 		_type = TextureType::TEXTURE2D;
 
-		if (_pixels != nullptr) {
-			stbi_image_free(_pixels);
-			_pixels = nullptr;
-		}
+		ReleasePixels();
 		stbi_set_flip_vertically_on_load(true);
 		_pixels = stbi_load_from_memory(filedata, size, &_width, &_height, &_channels, 0);
 		stbi_set_flip_vertically_on_load(false);
 		if (_pixels) {
 			// glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
+			DeleteTexture();
 			glGenTextures(1, &_id);
-			glBindTexture(GetTextureType(_type), _id);
+			StateCache::Get().BindTexture(GetTextureType(_type), _id);
 
 			glTexParameteri(GetTextureType(_type), GL_TEXTURE_WRAP_S, GL_REPEAT);
 			glTexParameteri(GetTextureType(_type), GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -112,6 +258,8 @@ namespace nmGfx
 
 			glTexImage2D(GetTextureType(_type), 0, GL_RGBA, _width, _height, 0, GetTextureFormat(_channels), GL_UNSIGNED_BYTE, _pixels);
 			glGenerateMipmap(GetTextureType(_type));
+			_memorySize = CalculateMemorySize(_width, _height, true);
+			RetainPixels();
 		} else {
 #ifdef NMGFX_PRINT_MESSAGES
 			printf("Error: Failed to load texture\n");
@@ -124,13 +272,11 @@ namespace nmGfx
 	void Texture::LoadCubemapFromFiles(CubemapImagePaths paths) {
 		_type = TextureType::CUBEMAP;
 
-		if (_pixels != nullptr) {
-			stbi_image_free(_pixels);
-			_pixels = nullptr;
-		}
+		ReleasePixels();
 
+		DeleteTexture();
 		glGenTextures(1, &_id);
-		glBindTexture(GetTextureType(_type), _id);
+		StateCache::Get().BindTexture(GetTextureType(_type), _id);
 
 		glTexParameteri(GetTextureType(_type), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GetTextureType(_type), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -150,6 +296,7 @@ namespace nmGfx
 					GL_UNSIGNED_BYTE,
 					data);
 				stbi_image_free(data);
+				_memorySize += CalculateMemorySize(_width, _height, false);
 			} else {
 #ifdef NMGFX_PRINT_MESSAGES
                 printf("Error: Failed to load texture: %s\n", paths[i].c_str());
@@ -158,8 +305,109 @@ namespace nmGfx
 		}
 	}
 
+	bool Texture::IsCompressedFormatSupported(BlockFormat format, bool srgb /*= false*/) {
+		// rgtc is core since 3.0, s3tc and bptc are extensions on 3.3. srgb s3tc needs one more
+		static int s3tc = -1;
+		static int s3tcSRGB = -1;
+		static int bptc = -1;
+		if (s3tc < 0) {
+			s3tc = 0;
+			s3tcSRGB = 0;
+			bptc = 0;
+
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+			for (GLint i = 0; i < count; i++) {
+				const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+				if (name == nullptr)
+					continue;
+				if (strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+					s3tc = 1;
+				else if (strcmp(name, "GL_EXT_texture_sRGB") == 0 || strcmp(name, "GL_EXT_texture_compression_s3tc_srgb") == 0)
+					s3tcSRGB = 1;
+				else if (strcmp(name, "GL_ARB_texture_compression_bptc") == 0)
+					bptc = 1;
+			}
+		}
+
+		return format == BlockFormat::BC1 ? s3tc == 1 && (!srgb || s3tcSRGB == 1)
+			: format == BlockFormat::BC3 ? s3tc == 1 && (!srgb || s3tcSRGB == 1)
+			: format == BlockFormat::BC5 ? !srgb
+			: format == BlockFormat::BC7 ? bptc == 1
+			: false;
+	}
+
+	bool Texture::LoadCompressedFromFile(const char *path) {
+		CompressedImage image;
+		if (!image.LoadFromFile(path)) {
+#ifdef NMGFX_PRINT_MESSAGES
+			printf("Error: Failed to load texture: %s\n", path);
+#endif
+			return false;
+		}
+		return LoadCompressed(image);
+	}
+
+	bool Texture::LoadCompressed(const CompressedImage &image) {
+		if (image.GetLevelCount() == 0)
+			return false;
+
+		_type = TextureType::TEXTURE2D;
+
+		ReleasePixels();
+		_downsampled.clear();
+		_downsampledWidth = 0;
+		_downsampledHeight = 0;
+
+		BlockFormat format = image.GetFormat();
+		bool srgb = image.IsSRGB();
+		_width = image.GetWidth();
+		_height = image.GetHeight();
+		_channels = format == BlockFormat::BC5 ? 2 : 4;
+
+		DeleteTexture();
+		glGenTextures(1, &_id);
+		StateCache::Get().BindTexture(GL_TEXTURE_2D, _id);
+
+		uint32_t levelCount = image.GetLevelCount();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// mip chain in file may stop before 1x1
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+		bool compressed = IsCompressedFormatSupported(format, srgb);
+		std::vector<uint8_t> decoded;
+		if (!compressed) {
+#ifdef NMGFX_PRINT_MESSAGES
+			printf("Warning: Compressed texture format is not supported by driver, decoding on cpu\n");
+#endif
+			decoded.resize((size_t)_width * _height * 4);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		}
+
+		for (uint32_t level = 0; level < levelCount; level++) {
+			const CompressedLevel &info = image.GetLevel(level);
+			if (compressed) {
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, GetCompressedFormat(format, srgb), info.width, info.height, 0, (GLsizei)info.size, image.GetLevelData(level));
+				_memorySize += info.size;
+			} else {
+				DecodeImage(format, image.GetLevelData(level), info.width, info.height, decoded.data());
+				glTexImage2D(GL_TEXTURE_2D, level, format == BlockFormat::BC5 ? GL_RG8 : srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, info.width, info.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+				_memorySize += (uint64_t)info.width * info.height * (format == BlockFormat::BC5 ? 2 : 4);
+			}
+		}
+
+		if (!compressed)
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		// nothing to retain up front, GetPixels reads back decompressed pixels on demand
+		return true;
+	}
+
 	void Texture::Use(int slot /*= 0*/) {
-		glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(GetTextureType(_type), _id);
+		_lastUsedFrame = s_CurrentFrame;
+		StateCache::Get().BindTexture(GetTextureType(_type), _id, slot);
 	}
 } // namespace nmGfx
@@ -3,15 +3,28 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
+
+#include "Core/nm_BlockCompression.hpp"
 
 namespace nmGfx
 {
+    class CompressedImage;
+
     enum class TextureType
     {
         TEXTURE2D = 0,
         CUBEMAP = 1,
     };
 
+    // What happens to cpu copy of pixels after they are uploaded
+    enum class PixelRetention
+    {
+        KEEP = 0,
+        DROP,             // GetPixels reads back from gl on demand
+        KEEP_DOWNSAMPLED, // small copy for GetDownsampledPixels, full size is read back on demand
+    };
+
     class Texture
     {
         public:
@@ -36,10 +49,30 @@ namespace nmGfx
         public:
             Texture() = default;
             ~Texture();
+            // owns the gl texture and _pixels, a copy would free both twice
+            Texture(const Texture&) = delete;
+            Texture& operator=(const Texture&) = delete;
 
             void Load2DFromFile(const char* path);
             bool Load2DFromMemory(const unsigned char* data, size_t size);
             void LoadCubemapFromFiles(CubemapImagePaths paths);
+			/**
+			 * @brief Loads block compressed DDS, KTX or KTX2 file with its precomputed mips
+			 * 
+			 * Formats the driver doesn't support are decoded on cpu and uploaded uncompressed.
+			 * sRGB formats get sRGB internal formats, sampling returns linear values.
+			 * 
+			 * Rows are uploaded in file order, the first row in the file is the bottom one (t = 0)
+			 * like in gl. nmTextureEncoder writes them that way. DDS files of other tools store the top
+			 * row first and show upside down compared with Load2DFromFile, flip them when encoding.
+			 * 
+			 * @param path
+			 * @return true on success
+			 */
+			bool LoadCompressedFromFile(const char* path);
+			bool LoadCompressed(const CompressedImage& image);
+			// Whether gl can sample format directly, must be called on gl thread
+			static bool IsCompressedFormatSupported(BlockFormat format, bool srgb = false);
             void Use(int slot = 0);
 
             
@@ -47,11 +80,42 @@ namespace nmGfx
             inline int GetWidth()  { return _width; }
             inline int GetHeight()  { return _height; }
             inline int GetChannels()  { return _channels; }
-			inline unsigned char *GetPixels() { return _pixels; }
-			// Loads from raw pixel data
-			void LoadFromData(unsigned char* data, int width, int height, int channels, TextureType type = TextureType::TEXTURE2D);
+			/**
+			 * @brief Full size pixels, read back from gl and kept if retention dropped them. Must be called on gl thread
+			 * 
+			 * @return unsigned char* nullptr for cubemaps and pending textures
+			 */
+			unsigned char *GetPixels();
+			/**
+			 * @brief Copy kept by PixelRetention::KEEP_DOWNSAMPLED, each side at most DOWNSAMPLED_SIZE
+			 * 
+			 * @return const unsigned char* nullptr if there is none
+			 */
+			const unsigned char *GetDownsampledPixels(int& width, int& height) const;
+			// Frees cpu copy of pixels, GetPixels reads them back again if needed
+			void ReleasePixels();
+
+			/**
+			 * @brief Sets what is kept in memory after following loads upload their pixels
+			 * 
+			 */
+			inline void SetPixelRetention(PixelRetention retention) { _retention = retention; }
+			inline PixelRetention GetPixelRetention() const { return _retention; }
+			// Retention of textures created after this call
+			static void SetDefaultPixelRetention(PixelRetention retention);
+
+			// Loads from raw pixel data. Data is copied if retention keeps pixels, caller keeps ownership
+			void LoadFromData(const unsigned char* data, int width, int height, int channels, TextureType type = TextureType::TEXTURE2D);
+
+			static const int DOWNSAMPLED_SIZE = 64;
 
             unsigned int ID() { return _id; }
+            // true while an async load is in flight, texture draws as placeholder until then
+            inline bool IsPending() const { return _pending; }
+            // Estimated gpu memory in bytes including mips, 0 while drawing as placeholder
+            inline uint64_t GetMemorySize() const { return _borrowedID ? 0 : _memorySize; }
+            // Renderer frame this texture was last drawn in
+            inline uint64_t GetLastUsedFrame() const { return _lastUsedFrame; }
         private:
             int _width = 0;
             int _height = 0;
@@ -61,8 +125,26 @@ namespace nmGfx
 			unsigned int _id = 0;
 
 			TextureType _type;
+			bool _pending = false;
+			bool _borrowedID = false; // _id belongs to placeholder
+			uint64_t _memorySize = 0;
+			uint64_t _lastUsedFrame = 0;
+
+			PixelRetention _retention = s_DefaultRetention;
+			std::vector<unsigned char> _downsampled;
+			int _downsampledWidth = 0;
+			int _downsampledHeight = 0;
+			static PixelRetention s_DefaultRetention;
+			static uint64_t s_CurrentFrame; // advanced by renderer, Use marks texture as drawn in it
+
+			// applies retention after pixels are uploaded
+			void RetainPixels();
+			// frees gl storage, borrowed placeholder ids are left alone
+			void DeleteTexture();
 
 			friend class Renderer;
+			friend class TextureLoader;
+			friend class TextureCache;
     };
 } // namespace nmGfx
 
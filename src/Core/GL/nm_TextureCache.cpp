@@ -0,0 +1,172 @@
+#include "nm_TextureCache.hpp"
+#include <algorithm>
+
+namespace nmGfx
+{
+    // tag keeps a path and a file containing same bytes apart
+    static uint64_t HashTextureKey(unsigned char tag, const void* data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void* data, size_t size) {
+            const unsigned char* bytes = (const unsigned char*)data;
+            for (size_t i = 0; i < size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        mix(&tag, 1);
+        mix(data, size);
+        return hash;
+    }
+
+    static bool IsCompressedPath(const std::string& path)
+    {
+        size_t dot = path.find_last_of('.');
+        if(dot == std::string::npos)
+            return false;
+
+        std::string extension = path.substr(dot + 1);
+        for(char& c : extension)
+            c = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+        return extension == "dds" || extension == "ktx" || extension == "ktx2";
+    }
+
+    TextureCache::TextureCache(TextureLoader& loader, const Texture& placeholder)
+        : _loader(loader), _placeholder(placeholder)
+    {
+    }
+
+    std::shared_ptr<Texture> TextureCache::Load(const std::string& path)
+    {
+        uint64_t key = HashTextureKey(0, path.data(), path.size());
+        auto it = _entries.find(key);
+        if(it != _entries.end() && it->second.path == path && it->second.fileData.empty())
+        {
+            std::shared_ptr<Texture> texture = it->second.texture.lock();
+            if(texture != nullptr)
+                return texture;
+        }
+
+        Entry entry;
+        entry.path = path;
+        entry.compressed = IsCompressedPath(path);
+
+        std::shared_ptr<Texture> texture;
+        if(entry.compressed)
+        {
+            texture = std::make_shared<Texture>();
+            if(!texture->LoadCompressedFromFile(path.c_str()))
+                BorrowPlaceholder(*texture);
+        }
+        else
+            texture = _loader.Load2DAsync(path, _placeholder);
+
+        // freshly loaded textures aren't eviction candidates before they get a chance to be drawn
+        texture->_lastUsedFrame = Texture::s_CurrentFrame;
+        entry.texture = texture;
+        // on hash collision entry is taken over, previous texture just isn't shared anymore
+        _entries[key] = std::move(entry);
+        return texture;
+    }
+
+    std::shared_ptr<Texture> TextureCache::LoadFromMemory(std::vector<unsigned char> fileData)
+    {
+        uint64_t key = HashTextureKey(1, fileData.data(), fileData.size());
+        auto it = _entries.find(key);
+        if(it != _entries.end() && it->second.fileData == fileData)
+        {
+            std::shared_ptr<Texture> texture = it->second.texture.lock();
+            if(texture != nullptr)
+                return texture;
+        }
+
+        Entry entry;
+        entry.fileData = fileData;
+        std::shared_ptr<Texture> texture = _loader.Load2DFromMemoryAsync(std::move(fileData), _placeholder);
+        texture->_lastUsedFrame = Texture::s_CurrentFrame;
+        entry.texture = texture;
+        _entries[key] = std::move(entry);
+        return texture;
+    }
+
+    void TextureCache::Reload(Entry& entry, const std::shared_ptr<Texture>& texture)
+    {
+        entry.evicted = false;
+        if(entry.compressed)
+        {
+            if(!texture->LoadCompressedFromFile(entry.path.c_str()))
+                BorrowPlaceholder(*texture);
+        }
+        else if(!entry.fileData.empty())
+            _loader.Reload2DFromMemoryAsync(texture, entry.fileData);
+        else
+            _loader.Reload2DAsync(texture, entry.path);
+    }
+
+    void TextureCache::Evict(Entry& entry, Texture& texture)
+    {
+        // size is kept so sprites sized by texture don't jump while it is reloaded
+        BorrowPlaceholder(texture);
+        entry.evicted = true;
+    }
+
+    void TextureCache::BorrowPlaceholder(Texture& texture)
+    {
+        texture.DeleteTexture();
+        texture._id = _placeholder._id;
+        texture._borrowedID = true;
+    }
+
+    void TextureCache::Update(uint64_t frame)
+    {
+        struct Candidate
+        {
+            uint64_t lastUsedFrame;
+            Entry* entry;
+            Texture* texture;
+        };
+        std::vector<Candidate> candidates;
+
+        _memoryUsage = 0;
+        for(auto it = _entries.begin(); it != _entries.end();)
+        {
+            std::shared_ptr<Texture> texture = it->second.texture.lock();
+            if(texture == nullptr)
+            {
+                it = _entries.erase(it);
+                continue;
+            }
+
+            Entry& entry = it->second;
+            if(entry.evicted && texture->_lastUsedFrame + 1 >= frame)
+                Reload(entry, texture);
+
+            _memoryUsage += texture->GetMemorySize();
+            if(!entry.evicted && !texture->IsPending() && texture->_lastUsedFrame + 1 < frame)
+                candidates.push_back(Candidate{ texture->_lastUsedFrame, &entry, texture.get() });
+            ++it;
+        }
+
+        if(_budget == 0 || _memoryUsage <= _budget)
+            return;
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.lastUsedFrame < b.lastUsedFrame;
+        });
+
+        for(Candidate& candidate : candidates)
+        {
+            if(_memoryUsage <= _budget)
+                break;
+
+            uint64_t size = candidate.texture->GetMemorySize();
+            if(size == 0)
+                continue;
+
+            Evict(*candidate.entry, *candidate.texture);
+            _memoryUsage -= size;
+        }
+        // anything still over budget was drawn last frame and stays
+    }
+} // namespace nmGfx
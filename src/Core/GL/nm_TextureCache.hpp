@@ -0,0 +1,87 @@
+#ifndef __NM_GFX_TEXTURE_CACHE_HPP__
+#define __NM_GFX_TEXTURE_CACHE_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "nm_Texture.hpp"
+#include "nm_TextureLoader.hpp"
+
+namespace nmGfx
+{
+    /**
+     * @brief Shares textures loaded from the same path or the same file contents
+     *
+     * Cache only keeps weak references, gl storage is freed when the last handle is released.
+     * When loaded textures exceed the memory budget, least recently drawn textures that weren't
+     * drawn in the last frame are evicted: their gl storage is freed and they draw as placeholder
+     * until they are drawn again and reloaded. Handles stay valid through eviction.
+     */
+    class TextureCache
+    {
+        public:
+            TextureCache(TextureLoader& loader, const Texture& placeholder);
+            TextureCache(const TextureCache&) = delete;
+            TextureCache& operator=(const TextureCache&) = delete;
+
+            /**
+             * @brief Returns texture already loaded from path or starts loading it
+             *
+             * DDS, KTX and KTX2 files are loaded right away with Texture::LoadCompressedFromFile,
+             * other images asynchronously through the loader.
+             *
+             * @param path
+             * @return std::shared_ptr<Texture>
+             */
+            std::shared_ptr<Texture> Load(const std::string& path);
+            /**
+             * @brief Returns texture already loaded from same file contents or starts loading it
+             *
+             * Contents are kept while the texture is alive so it can be reloaded after eviction.
+             */
+            std::shared_ptr<Texture> LoadFromMemory(std::vector<unsigned char> fileData);
+
+            /**
+             * @brief Drops released textures, reloads evicted textures drawn last frame and evicts over budget. Call once per frame
+             *
+             * @param frame current frame, textures last drawn before previous frame can be evicted
+             */
+            void Update(uint64_t frame);
+
+            // 0 -> unlimited
+            inline void SetBudget(uint64_t bytes) { _budget = bytes; }
+            inline uint64_t GetBudget() const { return _budget; }
+            // Estimated gpu memory of loaded textures on last Update
+            inline uint64_t GetMemoryUsage() const { return _memoryUsage; }
+            inline size_t GetCount() const { return _entries.size(); }
+
+        private:
+            struct Entry
+            {
+                std::string path;
+                std::vector<unsigned char> fileData;
+                std::weak_ptr<Texture> texture;
+                bool compressed = false;
+                bool evicted = false;
+            };
+
+            void Reload(Entry& entry, const std::shared_ptr<Texture>& texture);
+            void Evict(Entry& entry, Texture& texture);
+            // frees gl storage, texture draws as placeholder
+            void BorrowPlaceholder(Texture& texture);
+
+            TextureLoader& _loader;
+            const Texture& _placeholder;
+            std::unordered_map<uint64_t, Entry> _entries;
+
+            uint64_t _budget = 0;
+            uint64_t _memoryUsage = 0;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_TEXTURE_CACHE_HPP__
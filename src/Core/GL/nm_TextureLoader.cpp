@@ -0,0 +1,246 @@
+#include "nm_TextureLoader.hpp"
+#include <string.h>
+
+#include "glad/glad.h"
+#include "stb_image.h"
+#include "nm_StateCache.hpp"
+
+namespace nmGfx
+{
+    static GLenum GetTextureFormat(int nrChannels)
+    {
+        return nrChannels == 1 ? GL_RED
+            : nrChannels == 2 ? GL_RG
+            : nrChannels == 3 ? GL_RGB
+            : nrChannels == 4 ? GL_RGBA
+            : GL_NONE;
+    }
+
+    TextureLoader::TextureLoader(ThreadPool& pool /*= ThreadPool::Shared()*/)
+        : _pool(pool), _decoded(std::make_shared<DecodedQueue>())
+    {
+    }
+
+    TextureLoader::Job::~Job()
+    {
+        stbi_image_free(pixels);
+    }
+
+    TextureLoader::~TextureLoader()
+    {
+        for(auto& job : _uploads)
+        {
+            if(job->textureID != 0)
+            {
+                StateCache::Get().OnTextureDeleted(job->textureID);
+                glDeleteTextures(1, &job->textureID);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_decoded->mutex);
+            _decoded->jobs.clear();
+        }
+
+        if(_pbo != 0)
+        {
+            StateCache::Get().OnBufferDeleted(_pbo);
+            glDeleteBuffers(1, &_pbo);
+        }
+    }
+
+    std::shared_ptr<Texture> TextureLoader::Load2DAsync(const std::string& path, const Texture& placeholder)
+    {
+        std::shared_ptr<Texture> texture = CreatePlaceholder(placeholder);
+        Reload2DAsync(texture, path);
+        return texture;
+    }
+
+    std::shared_ptr<Texture> TextureLoader::Load2DFromMemoryAsync(std::vector<unsigned char> fileData, const Texture& placeholder)
+    {
+        std::shared_ptr<Texture> texture = CreatePlaceholder(placeholder);
+        Reload2DFromMemoryAsync(texture, std::move(fileData));
+        return texture;
+    }
+
+    void TextureLoader::Reload2DAsync(const std::shared_ptr<Texture>& texture, const std::string& path)
+    {
+        auto job = std::make_shared<Job>();
+        job->path = path;
+        Queue(job, texture);
+    }
+
+    void TextureLoader::Reload2DFromMemoryAsync(const std::shared_ptr<Texture>& texture, std::vector<unsigned char> fileData)
+    {
+        auto job = std::make_shared<Job>();
+        job->fileData = std::move(fileData);
+        Queue(job, texture);
+    }
+
+    std::shared_ptr<Texture> TextureLoader::CreatePlaceholder(const Texture& placeholder)
+    {
+        auto texture = std::make_shared<Texture>();
+        texture->_type = TextureType::TEXTURE2D;
+        texture->_id = placeholder._id;
+        texture->_borrowedID = true;
+        texture->_width = placeholder._width;
+        texture->_height = placeholder._height;
+        texture->_channels = placeholder._channels;
+        return texture;
+    }
+
+    void TextureLoader::Queue(std::shared_ptr<Job> job, const std::shared_ptr<Texture>& texture)
+    {
+        texture->_pending = true;
+        job->texture = texture;
+
+        std::shared_ptr<DecodedQueue> decoded = _decoded;
+        {
+            std::lock_guard<std::mutex> lock(decoded->mutex);
+            decoded->decoding++;
+        }
+
+        _pool.Submit([job, decoded]() {
+            // nobody is waiting for it anymore
+            if(!job->texture.expired())
+                Decode(*job);
+
+            std::lock_guard<std::mutex> lock(decoded->mutex);
+            decoded->decoding--;
+            decoded->jobs.push_back(job);
+        });
+    }
+
+    void TextureLoader::Decode(Job& job)
+    {
+        stbi_set_flip_vertically_on_load_thread(true);
+        if(!job.path.empty())
+            job.pixels = stbi_load(job.path.c_str(), &job.width, &job.height, &job.channels, 0);
+        else
+            job.pixels = stbi_load_from_memory(job.fileData.data(), (int)job.fileData.size(), &job.width, &job.height, &job.channels, 0);
+        stbi_set_flip_vertically_on_load_thread(false);
+
+        job.fileData.clear();
+        job.fileData.shrink_to_fit();
+    }
+
+    void TextureLoader::Update(uint64_t budgetBytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_decoded->mutex);
+            while(!_decoded->jobs.empty())
+            {
+                _uploads.push_back(std::move(_decoded->jobs.front()));
+                _decoded->jobs.pop_front();
+            }
+        }
+
+        while(!_uploads.empty())
+        {
+            Job& job = *_uploads.front();
+            std::shared_ptr<Texture> texture = job.texture.lock();
+
+            if(texture == nullptr || job.pixels == nullptr)
+            {
+#ifdef NMGFX_PRINT_MESSAGES
+                if(texture != nullptr)
+                    printf("Error: Failed to load texture: %s\n", job.path.c_str());
+#endif
+                FinishJob(job, texture.get());
+                _uploads.pop_front();
+                continue;
+            }
+
+            if(budgetBytes == 0)
+                break;
+
+            StateCache& stateCache = StateCache::Get();
+            if(job.textureID == 0)
+            {
+                glGenTextures(1, &job.textureID);
+                stateCache.BindTexture(GL_TEXTURE_2D, job.textureID);
+
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, job.width, job.height, 0, GetTextureFormat(job.channels), GL_UNSIGNED_BYTE, nullptr);
+            }
+
+            uint64_t rowSize = (uint64_t)job.width * job.channels;
+            int rows = (int)(budgetBytes / rowSize);
+            rows = rows < 1 ? 1 : rows;
+            rows = rows > job.height - job.uploadedRows ? job.height - job.uploadedRows : rows;
+            uint64_t size = rowSize * rows;
+
+            if(_pbo == 0)
+                glGenBuffers(1, &_pbo);
+            stateCache.BindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
+
+            // orphan so writing doesn't wait for previous transfer
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if(mapped != nullptr)
+            {
+                memcpy(mapped, job.pixels + rowSize * job.uploadedRows, size);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+                stateCache.BindTexture(GL_TEXTURE_2D, job.textureID);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job.uploadedRows, job.width, rows, GetTextureFormat(job.channels), GL_UNSIGNED_BYTE, nullptr);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            }
+            stateCache.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            job.uploadedRows += rows;
+            budgetBytes = size >= budgetBytes ? 0 : budgetBytes - size;
+
+            if(job.uploadedRows >= job.height)
+            {
+                stateCache.BindTexture(GL_TEXTURE_2D, job.textureID);
+                glGenerateMipmap(GL_TEXTURE_2D);
+
+                FinishJob(job, texture.get());
+                _uploads.pop_front();
+            }
+        }
+    }
+
+    void TextureLoader::FinishJob(Job& job, Texture* texture)
+    {
+        if(texture == nullptr)
+        {
+            // texture was released before upload finished, job frees pixels
+            if(job.textureID != 0)
+            {
+                StateCache::Get().OnTextureDeleted(job.textureID);
+                glDeleteTextures(1, &job.textureID);
+            }
+        }
+        else if(job.pixels != nullptr)
+        {
+            texture->ReleasePixels();
+            texture->DeleteTexture();
+
+            uint64_t size = (uint64_t)job.width * job.height * 4;
+            texture->_id = job.textureID;
+            texture->_memorySize = size + size / 3;
+            texture->_width = job.width;
+            texture->_height = job.height;
+            texture->_channels = job.channels;
+            texture->_pixels = job.pixels;
+            texture->RetainPixels();
+            job.pixels = nullptr;
+        }
+
+        if(texture != nullptr)
+            texture->_pending = false;
+        job.textureID = 0;
+    }
+
+    uint32_t TextureLoader::GetPendingCount()
+    {
+        std::lock_guard<std::mutex> lock(_decoded->mutex);
+        return _decoded->decoding + (uint32_t)_decoded->jobs.size() + (uint32_t)_uploads.size();
+    }
+} // namespace nmGfx
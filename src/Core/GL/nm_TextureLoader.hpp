@@ -0,0 +1,112 @@
+#ifndef __NM_GFX_TEXTURE_LOADER_HPP__
+#define __NM_GFX_TEXTURE_LOADER_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+#include "nm_Texture.hpp"
+#include "Core/nm_ThreadPool.hpp"
+
+namespace nmGfx
+{
+    /**
+     * @brief Decodes textures on worker threads and streams them to gl through a pixel buffer object
+     *
+     * Returned textures draw as placeholder until their upload finishes, Texture::IsPending tells when.
+     * Load calls can be made from any thread, Update must be called on gl thread.
+     */
+    class TextureLoader
+    {
+        public:
+            TextureLoader(ThreadPool& pool = ThreadPool::Shared());
+            ~TextureLoader();
+            TextureLoader(const TextureLoader&) = delete;
+            TextureLoader& operator=(const TextureLoader&) = delete;
+
+            /**
+             * @brief Queues 2d texture for decoding, same result as Texture::Load2DFromFile once uploaded
+             *
+             * @param path
+             * @param placeholder drawn until upload finishes, must outlive returned texture's pending state
+             * @return std::shared_ptr<Texture>
+             */
+            std::shared_ptr<Texture> Load2DAsync(const std::string& path, const Texture& placeholder);
+            /**
+             * @brief Queues encoded image in memory for decoding, same result as Texture::Load2DFromMemory once uploaded
+             *
+             */
+            std::shared_ptr<Texture> Load2DFromMemoryAsync(std::vector<unsigned char> fileData, const Texture& placeholder);
+
+            /**
+             * @brief Queues new pixels for existing texture, it keeps drawing with its current id until upload finishes
+             *
+             * Previous gl storage of texture is freed when new one is swapped in.
+             */
+            void Reload2DAsync(const std::shared_ptr<Texture>& texture, const std::string& path);
+            void Reload2DFromMemoryAsync(const std::shared_ptr<Texture>& texture, std::vector<unsigned char> fileData);
+
+            /**
+             * @brief Uploads decoded textures, at least one row is uploaded per call even if it exceeds budget
+             *
+             * Large textures are uploaded in row strips over several calls.
+             *
+             * @param budgetBytes pixel bytes to upload
+             */
+            void Update(uint64_t budgetBytes);
+
+            /**
+             * @brief Textures that are decoding or waiting for upload
+             *
+             * @return uint32_t
+             */
+            uint32_t GetPendingCount();
+
+        private:
+            struct Job
+            {
+                Job() = default;
+                // frees pixels that weren't handed to a texture, also when a decode finishes after loader is gone
+                ~Job();
+                Job(const Job&) = delete;
+                Job& operator=(const Job&) = delete;
+
+                std::weak_ptr<Texture> texture;
+                std::string path;
+                std::vector<unsigned char> fileData;
+
+                unsigned char* pixels = nullptr;
+                int width = 0;
+                int height = 0;
+                int channels = 0;
+
+                unsigned int textureID = 0;
+                int uploadedRows = 0;
+            };
+
+            // shared with decode tasks, so tasks finishing after loader is destroyed don't touch it
+            struct DecodedQueue
+            {
+                std::mutex mutex;
+                std::deque<std::shared_ptr<Job>> jobs;
+                uint32_t decoding = 0;
+            };
+
+            std::shared_ptr<Texture> CreatePlaceholder(const Texture& placeholder);
+            void Queue(std::shared_ptr<Job> job, const std::shared_ptr<Texture>& texture);
+            static void Decode(Job& job);
+            void FinishJob(Job& job, Texture* texture);
+
+            ThreadPool& _pool;
+            std::shared_ptr<DecodedQueue> _decoded;
+            std::deque<std::shared_ptr<Job>> _uploads; // gl thread only
+            unsigned int _pbo = 0;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_TEXTURE_LOADER_HPP__
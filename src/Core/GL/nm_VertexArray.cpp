@@ -2,6 +2,7 @@
 #include "glad/glad.h"
 #include <algorithm>
 #include "nm_Model.hpp"
+#include "nm_StateCache.hpp"
 
 #include <iostream>
 
@@ -14,27 +15,35 @@ namespace nmGfx
 
     VertexArray::~VertexArray()
     {
+        StateCache::Get().OnVertexArrayDeleted(_id);
         glDeleteVertexArrays(1, &_id);
     }
 
     void VertexArray::Use() const
     {
-        glBindVertexArray(_id);
+        StateCache::Get().BindVertexArray(_id);
     }
 
     // static
     void VertexArray::Unbind()
     {
-        glBindVertexArray(0);
+        StateCache::Get().BindVertexArray(0);
     }
 
 
-    static uint32_t GetGLAttributeSize(AttributeType type)
+    uint32_t GetAttributeSize(AttributeType type)
     {
         return type == AttributeType::FLOAT ? sizeof(GLfloat)
             : type == AttributeType::VEC2  ? sizeof(GLfloat) * 2
             : type == AttributeType::VEC3  ? sizeof(GLfloat) * 3
             : type == AttributeType::VEC4  ? sizeof(GLfloat) * 4
+            : type == AttributeType::INT   ? sizeof(GLint)
+            : type == AttributeType::MAT4  ? sizeof(GLfloat) * 16
+            : type == AttributeType::HALF2 ? sizeof(GLhalf) * 2
+            : type == AttributeType::HALF4 ? sizeof(GLhalf) * 4
+            : type == AttributeType::INT_2_10_10_10_REV ? sizeof(GLuint)
+            : type == AttributeType::UNORM8x4  ? sizeof(GLubyte) * 4
+            : type == AttributeType::UNORM16x2 ? sizeof(GLushort) * 2
             : 0; 
     }
     static uint32_t GetGLAttributeElementCount(AttributeType type)
@@ -43,6 +52,13 @@ namespace nmGfx
             : type == AttributeType::VEC2  ? 2
             : type == AttributeType::VEC3  ? 3
             : type == AttributeType::VEC4  ? 4
+            : type == AttributeType::INT   ? 1
+            : type == AttributeType::MAT4  ? 4
+            : type == AttributeType::HALF2 ? 2
+            : type == AttributeType::HALF4 ? 4
+            : type == AttributeType::INT_2_10_10_10_REV ? 4
+            : type == AttributeType::UNORM8x4  ? 4
+            : type == AttributeType::UNORM16x2 ? 2
             : 0; 
     }
     static GLenum GetGLAttributeType(AttributeType type)
@@ -51,8 +67,30 @@ namespace nmGfx
             : type == AttributeType::VEC2  ? GL_FLOAT
             : type == AttributeType::VEC3  ? GL_FLOAT
             : type == AttributeType::VEC4  ? GL_FLOAT
+            : type == AttributeType::INT   ? GL_INT
+            : type == AttributeType::MAT4  ? GL_FLOAT
+            : type == AttributeType::HALF2 ? GL_HALF_FLOAT
+            : type == AttributeType::HALF4 ? GL_HALF_FLOAT
+            : type == AttributeType::INT_2_10_10_10_REV ? GL_INT_2_10_10_10_REV
+            : type == AttributeType::UNORM8x4  ? GL_UNSIGNED_BYTE
+            : type == AttributeType::UNORM16x2 ? GL_UNSIGNED_SHORT
             : GL_NONE; 
     }
+    static bool IsIntegerAttribute(AttributeType type)
+    {
+        return type == AttributeType::INT;
+    }
+    // integer storage read as [0, 1] or [-1, 1] floats
+    static bool IsNormalizedAttribute(AttributeType type)
+    {
+        return type == AttributeType::INT_2_10_10_10_REV
+            || type == AttributeType::UNORM8x4
+            || type == AttributeType::UNORM16x2;
+    }
+    static uint32_t GetGLAttributeSlotCount(AttributeType type)
+    {
+        return type == AttributeType::MAT4 ? 4 : 1;
+    }
 
     void VertexArray::ResetAttributes()
     {
@@ -62,33 +100,78 @@ namespace nmGfx
             glDisableVertexAttribArray(attribute.slot);
         }
         _usedAttributes.clear();
+        _attributeSizeInBytes = 0;
+
+        for (const auto& attribute : _usedInstanceAttributes) {
+            for (uint32_t i = 0; i < GetGLAttributeSlotCount(attribute.type); i++)
+                glDisableVertexAttribArray(attribute.slot + i);
+        }
+        _usedInstanceAttributes.clear();
+        _instanceAttributeSizeInBytes = 0;
     }
 
     void VertexArray::SetAttribute(uint32_t slot, AttributeType type) 
     {
         _usedAttributes.emplace_back(slot, type);
-        _attributeSizeInBytes += GetGLAttributeSize(type);
+        _attributeSizeInBytes += GetAttributeSize(type);
     }
 
     void VertexArray::UploadAttributes()
     {
         Use();
-        std::sort(_usedAttributes.begin(), _usedAttributes.end());
+        UploadAttributeList(_usedAttributes, _attributeSizeInBytes, 0);
+    }
+
+    void VertexArray::SetInstanceAttribute(uint32_t slot, AttributeType type)
+    {
+        _usedInstanceAttributes.emplace_back(slot, type);
+        _instanceAttributeSizeInBytes += GetAttributeSize(type);
+    }
+
+    void VertexArray::UploadInstanceAttributes()
+    {
+        Use();
+        UploadAttributeList(_usedInstanceAttributes, _instanceAttributeSizeInBytes, 1);
+    }
+
+    void VertexArray::UploadAttributeList(std::vector<Attribute>& attributes, uint32_t stride, uint32_t divisor)
+    {
+        std::sort(attributes.begin(), attributes.end());
         
         uint64_t usedBytes = 0;
-        for(const auto& attribute : _usedAttributes)
+        for(const auto& attribute : attributes)
         {
-            glVertexAttribPointer(
-                attribute.slot,                               // slot
-                GetGLAttributeElementCount(attribute.type),  // size (element count)
-                GetGLAttributeType(attribute.type),         // type
-                GL_FALSE,                                  // normalized
-                _attributeSizeInBytes,                   // stride
-                (const void*)usedBytes                   // pointer
-                );
-            glEnableVertexAttribArray(attribute.slot);
-
-            usedBytes += GetGLAttributeSize(attribute.type);
+            uint32_t slotCount = GetGLAttributeSlotCount(attribute.type);
+            uint32_t slotSize = GetAttributeSize(attribute.type) / slotCount;
+
+            for(uint32_t i = 0; i < slotCount; i++)
+            {
+                if(IsIntegerAttribute(attribute.type))
+                {
+                    glVertexAttribIPointer(
+                        attribute.slot + i,
+                        GetGLAttributeElementCount(attribute.type),
+                        GetGLAttributeType(attribute.type),
+                        stride,
+                        (const void*)usedBytes
+                        );
+                }
+                else
+                {
+                    glVertexAttribPointer(
+                        attribute.slot + i,                           // slot
+                        GetGLAttributeElementCount(attribute.type),  // size (element count)
+                        GetGLAttributeType(attribute.type),         // type
+                        IsNormalizedAttribute(attribute.type) ? GL_TRUE : GL_FALSE, // normalized
+                        stride,                                  // stride
+                        (const void*)usedBytes                   // pointer
+                        );
+                }
+                glEnableVertexAttribArray(attribute.slot + i);
+                glVertexAttribDivisor(attribute.slot + i, divisor);
+
+                usedBytes += slotSize;
+            }
         }
     }
 } // namespace nmGfx
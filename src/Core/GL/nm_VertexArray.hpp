@@ -19,9 +19,15 @@ namespace nmGfx
 
             static void Unbind();
 
+            inline unsigned int ID() const { return _id; }
+
             void ResetAttributes();
 			void SetAttribute(uint32_t slot, nmGfx::AttributeType type);
 			void UploadAttributes();
+
+			// Attributes advanced once per instance, read from currently bound vertex buffer
+			void SetInstanceAttribute(uint32_t slot, nmGfx::AttributeType type);
+			void UploadInstanceAttributes();
         private:
             unsigned int _id = 0;
 
@@ -41,9 +47,13 @@ namespace nmGfx
 				{
 				}
 			};
+			void UploadAttributeList(std::vector<Attribute>& attributes, uint32_t stride, uint32_t divisor);
+
 			uint32_t _attributeSizeInBytes = 0;
+			uint32_t _instanceAttributeSizeInBytes = 0;
 
 			std::vector<Attribute> _usedAttributes;
+			std::vector<Attribute> _usedInstanceAttributes;
 
 			friend class Model;
     };
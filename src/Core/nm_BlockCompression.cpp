@@ -0,0 +1,781 @@
+#include "nm_BlockCompression.hpp"
+#include <string.h>
+#include <math.h>
+
+namespace nmGfx
+{
+    uint32_t GetBlockSize(BlockFormat format)
+    {
+        return format == BlockFormat::BC1 ? 8
+            : format == BlockFormat::BC3 ? 16
+            : format == BlockFormat::BC5 ? 16
+            : format == BlockFormat::BC7 ? 16
+            : 0;
+    }
+
+    size_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height)
+    {
+        size_t blocksX = width > 0 ? (width + 3) / 4 : 1;
+        size_t blocksY = height > 0 ? (height + 3) / 4 : 1;
+        return blocksX * blocksY * GetBlockSize(format);
+    }
+
+    // ---------------------------------------------------------------- decoding
+
+    static void Decode565(uint16_t color, uint8_t* rgb)
+    {
+        uint8_t r = (color >> 11) & 31;
+        uint8_t g = (color >> 5) & 63;
+        uint8_t b = color & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    static void DecodeBC1Colors(const uint8_t* block, uint8_t* rgba, bool forceFourColors)
+    {
+        uint16_t c0 = block[0] | (block[1] << 8);
+        uint16_t c1 = block[2] | (block[3] << 8);
+
+        uint8_t palette[4][4];
+        Decode565(c0, palette[0]);
+        Decode565(c1, palette[1]);
+        palette[0][3] = palette[1][3] = 255;
+
+        if(c0 > c1 || forceFourColors)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            palette[2][3] = palette[3][3] = 255;
+        }
+        else
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 0;
+        }
+
+        uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+        for(int i = 0; i < 16; i++)
+            memcpy(rgba + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+    }
+
+    // single channel block, written to every 4th byte of out
+    static void DecodeBC4Channel(const uint8_t* block, uint8_t* out)
+    {
+        uint8_t palette[8];
+        palette[0] = block[0];
+        palette[1] = block[1];
+        if(palette[0] > palette[1])
+        {
+            for(int i = 1; i < 7; i++)
+                palette[i + 1] = ((7 - i) * palette[0] + i * palette[1]) / 7;
+        }
+        else
+        {
+            for(int i = 1; i < 5; i++)
+                palette[i + 1] = ((5 - i) * palette[0] + i * palette[1]) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for(int i = 0; i < 6; i++)
+            indices |= (uint64_t)block[2 + i] << (i * 8);
+        for(int i = 0; i < 16; i++)
+            out[i * 4] = palette[(indices >> (i * 3)) & 7];
+    }
+
+    struct BC7Mode
+    {
+        uint8_t subsets;
+        uint8_t partitionBits;
+        uint8_t rotationBits;
+        uint8_t indexSelectionBits;
+        uint8_t colorBits;
+        uint8_t alphaBits;
+        uint8_t endpointPBits;
+        uint8_t sharedPBits;
+        uint8_t indexBits;
+        uint8_t secondaryIndexBits;
+    };
+
+    static const BC7Mode BC7_MODES[8] = {
+        { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+    };
+
+    // bit n set -> pixel n belongs to subset 1
+    static const uint16_t BC7_PARTITIONS_2[64] = {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+        0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+        0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+        0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+        0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // 2 bits per pixel, pixel 0 in lowest bits
+    static const uint32_t BC7_PARTITIONS_3[64] = {
+        0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+        0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+        0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+        0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+        0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+        0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+        0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+        0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+    };
+
+    static const uint8_t BC7_ANCHOR_2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+    };
+
+    static const uint8_t BC7_ANCHOR_3_SECOND[64] = {
+         3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+         3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+         8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+         3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+    };
+
+    static const uint8_t BC7_ANCHOR_3_THIRD[64] = {
+        15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+        15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+        15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+        15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+    };
+
+    static const uint8_t BC7_WEIGHTS_2[4] = { 0, 21, 43, 64 };
+    static const uint8_t BC7_WEIGHTS_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    static const uint8_t BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    static const uint8_t* GetBC7Weights(uint32_t bits)
+    {
+        return bits == 2 ? BC7_WEIGHTS_2
+            : bits == 3 ? BC7_WEIGHTS_3
+            : BC7_WEIGHTS_4;
+    }
+
+    static inline uint8_t BC7Interpolate(uint8_t e0, uint8_t e1, uint8_t weight)
+    {
+        return (uint8_t)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+    }
+
+    static uint32_t GetBC7Subset(const BC7Mode& mode, uint32_t partition, uint32_t pixel)
+    {
+        if(mode.subsets == 2)
+            return (BC7_PARTITIONS_2[partition] >> pixel) & 1;
+        if(mode.subsets == 3)
+            return (BC7_PARTITIONS_3[partition] >> (pixel * 2)) & 3;
+        return 0;
+    }
+
+    static bool IsBC7Anchor(const BC7Mode& mode, uint32_t partition, uint32_t pixel)
+    {
+        if(pixel == 0)
+            return true;
+        if(mode.subsets == 2)
+            return pixel == BC7_ANCHOR_2[partition];
+        if(mode.subsets == 3)
+            return pixel == BC7_ANCHOR_3_SECOND[partition] || pixel == BC7_ANCHOR_3_THIRD[partition];
+        return false;
+    }
+
+    struct BitReader
+    {
+        const uint8_t* data;
+        uint32_t position = 0;
+
+        uint32_t Read(uint32_t count)
+        {
+            uint32_t value = 0;
+            for(uint32_t i = 0; i < count; i++, position++)
+                value |= ((data[position >> 3] >> (position & 7)) & 1u) << i;
+            return value;
+        }
+    };
+
+    static void DecodeBC7(const uint8_t* block, uint8_t* rgba)
+    {
+        uint32_t modeIndex = 0;
+        while(modeIndex < 8 && !(block[0] & (1 << modeIndex)))
+            modeIndex++;
+        if(modeIndex == 8)
+        {
+            memset(rgba, 0, 64);
+            return;
+        }
+
+        const BC7Mode& mode = BC7_MODES[modeIndex];
+        BitReader bits{ block, modeIndex + 1 };
+
+        uint32_t partition = bits.Read(mode.partitionBits);
+        uint32_t rotation = bits.Read(mode.rotationBits);
+        uint32_t indexSelection = bits.Read(mode.indexSelectionBits);
+
+        // [subset * 2 + endpoint][channel]
+        uint8_t endpoints[6][4] = {};
+        uint32_t endpointCount = mode.subsets * 2;
+        for(uint32_t c = 0; c < 3; c++)
+            for(uint32_t e = 0; e < endpointCount; e++)
+                endpoints[e][c] = bits.Read(mode.colorBits);
+        for(uint32_t e = 0; e < endpointCount; e++)
+            endpoints[e][3] = mode.alphaBits > 0 ? bits.Read(mode.alphaBits) : 255;
+
+        uint32_t colorPrecision = mode.colorBits;
+        uint32_t alphaPrecision = mode.alphaBits;
+        if(mode.endpointPBits || mode.sharedPBits)
+        {
+            uint8_t pBits[6];
+            if(mode.endpointPBits)
+            {
+                for(uint32_t e = 0; e < endpointCount; e++)
+                    pBits[e] = bits.Read(1);
+            }
+            else
+            {
+                for(uint32_t s = 0; s < mode.subsets; s++)
+                    pBits[s * 2] = pBits[s * 2 + 1] = bits.Read(1);
+            }
+
+            for(uint32_t e = 0; e < endpointCount; e++)
+            {
+                for(uint32_t c = 0; c < 3; c++)
+                    endpoints[e][c] = (endpoints[e][c] << 1) | pBits[e];
+                if(mode.alphaBits > 0)
+                    endpoints[e][3] = (endpoints[e][3] << 1) | pBits[e];
+            }
+            colorPrecision++;
+            if(mode.alphaBits > 0)
+                alphaPrecision++;
+        }
+
+        // expand to 8 bits by replicating high bits
+        for(uint32_t e = 0; e < endpointCount; e++)
+        {
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                uint8_t value = endpoints[e][c] << (8 - colorPrecision);
+                endpoints[e][c] = value | (value >> colorPrecision);
+            }
+            if(mode.alphaBits > 0)
+            {
+                uint8_t value = endpoints[e][3] << (8 - alphaPrecision);
+                endpoints[e][3] = value | (value >> alphaPrecision);
+            }
+        }
+
+        uint8_t indices[16];
+        for(uint32_t i = 0; i < 16; i++)
+            indices[i] = bits.Read(IsBC7Anchor(mode, partition, i) ? mode.indexBits - 1 : mode.indexBits);
+
+        uint8_t secondaryIndices[16] = {};
+        if(mode.secondaryIndexBits > 0)
+        {
+            for(uint32_t i = 0; i < 16; i++)
+                secondaryIndices[i] = bits.Read(i == 0 ? mode.secondaryIndexBits - 1 : mode.secondaryIndexBits);
+        }
+
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t subset = GetBC7Subset(mode, partition, i);
+            const uint8_t* e0 = endpoints[subset * 2];
+            const uint8_t* e1 = endpoints[subset * 2 + 1];
+            uint8_t* pixel = rgba + i * 4;
+
+            if(mode.secondaryIndexBits == 0)
+            {
+                const uint8_t* weights = GetBC7Weights(mode.indexBits);
+                for(uint32_t c = 0; c < 4; c++)
+                    pixel[c] = BC7Interpolate(e0[c], e1[c], weights[indices[i]]);
+            }
+            else
+            {
+                // index selection swaps which index set drives color and which drives alpha
+                uint32_t colorBits = indexSelection ? mode.secondaryIndexBits : mode.indexBits;
+                uint32_t alphaBits = indexSelection ? mode.indexBits : mode.secondaryIndexBits;
+                uint8_t colorIndex = indexSelection ? secondaryIndices[i] : indices[i];
+                uint8_t alphaIndex = indexSelection ? indices[i] : secondaryIndices[i];
+
+                for(uint32_t c = 0; c < 3; c++)
+                    pixel[c] = BC7Interpolate(e0[c], e1[c], GetBC7Weights(colorBits)[colorIndex]);
+                pixel[3] = BC7Interpolate(e0[3], e1[3], GetBC7Weights(alphaBits)[alphaIndex]);
+            }
+
+            if(rotation > 0)
+            {
+                uint8_t swap = pixel[3];
+                pixel[3] = pixel[rotation - 1];
+                pixel[rotation - 1] = swap;
+            }
+        }
+    }
+
+    void DecodeBlock(BlockFormat format, const uint8_t* block, uint8_t* rgba)
+    {
+        switch(format)
+        {
+            case BlockFormat::BC1:
+                DecodeBC1Colors(block, rgba, false);
+                break;
+            case BlockFormat::BC3:
+                DecodeBC1Colors(block + 8, rgba, true);
+                DecodeBC4Channel(block, rgba + 3);
+                break;
+            case BlockFormat::BC5:
+                DecodeBC4Channel(block, rgba);
+                DecodeBC4Channel(block + 8, rgba + 1);
+                for(int i = 0; i < 16; i++)
+                {
+                    rgba[i * 4 + 2] = 0;
+                    rgba[i * 4 + 3] = 255;
+                }
+                break;
+            case BlockFormat::BC7:
+                DecodeBC7(block, rgba);
+                break;
+            default:
+                memset(rgba, 0, 64);
+                break;
+        }
+    }
+
+    void DecodeImage(BlockFormat format, const uint8_t* data, uint32_t width, uint32_t height, uint8_t* rgba)
+    {
+        uint32_t blockSize = GetBlockSize(format);
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        uint8_t pixels[64];
+
+        for(uint32_t by = 0; by < blocksY; by++)
+        {
+            for(uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                DecodeBlock(format, data + ((size_t)by * blocksX + bx) * blockSize, pixels);
+
+                for(uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+                {
+                    uint32_t columns = width - bx * 4 < 4 ? width - bx * 4 : 4;
+                    memcpy(rgba + (((size_t)(by * 4 + y) * width) + bx * 4) * 4, pixels + y * 16, columns * 4);
+                }
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------- encoding
+
+    // principal axis of channels [0, count) by power iteration, returns false for flat blocks
+    static bool GetPrincipalAxis(const uint8_t* rgba, uint32_t count, float* mean, float* axis)
+    {
+        for(uint32_t c = 0; c < count; c++)
+        {
+            mean[c] = 0.f;
+            for(int i = 0; i < 16; i++)
+                mean[c] += rgba[i * 4 + c];
+            mean[c] /= 16.f;
+        }
+
+        float covariance[4][4] = {};
+        for(int i = 0; i < 16; i++)
+        {
+            float d[4];
+            for(uint32_t c = 0; c < count; c++)
+                d[c] = rgba[i * 4 + c] - mean[c];
+            for(uint32_t a = 0; a < count; a++)
+                for(uint32_t b = 0; b < count; b++)
+                    covariance[a][b] += d[a] * d[b];
+        }
+
+        for(uint32_t c = 0; c < count; c++)
+            axis[c] = 1.f;
+        for(int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {};
+            float length = 0.f;
+            for(uint32_t a = 0; a < count; a++)
+            {
+                for(uint32_t b = 0; b < count; b++)
+                    next[a] += covariance[a][b] * axis[b];
+                length += next[a] * next[a];
+            }
+            if(length < 1e-6f)
+                return false;
+
+            length = 1.f / sqrtf(length);
+            for(uint32_t c = 0; c < count; c++)
+                axis[c] = next[c] * length;
+        }
+        return true;
+    }
+
+    // endpoints at extremes of projection on principal axis
+    static void GetAxisEndpoints(const uint8_t* rgba, uint32_t count, float* e0, float* e1)
+    {
+        float mean[4], axis[4];
+        if(!GetPrincipalAxis(rgba, count, mean, axis))
+        {
+            for(uint32_t c = 0; c < count; c++)
+                e0[c] = e1[c] = mean[c];
+            return;
+        }
+
+        float minT = 1e9f, maxT = -1e9f;
+        for(int i = 0; i < 16; i++)
+        {
+            float t = 0.f;
+            for(uint32_t c = 0; c < count; c++)
+                t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+            minT = t < minT ? t : minT;
+            maxT = t > maxT ? t : maxT;
+        }
+
+        for(uint32_t c = 0; c < count; c++)
+        {
+            e0[c] = mean[c] + axis[c] * minT;
+            e1[c] = mean[c] + axis[c] * maxT;
+            e0[c] = e0[c] < 0.f ? 0.f : e0[c] > 255.f ? 255.f : e0[c];
+            e1[c] = e1[c] < 0.f ? 0.f : e1[c] > 255.f ? 255.f : e1[c];
+        }
+    }
+
+    static uint16_t Encode565(const float* rgb)
+    {
+        uint16_t r = (uint16_t)(rgb[0] * 31.f / 255.f + 0.5f);
+        uint16_t g = (uint16_t)(rgb[1] * 63.f / 255.f + 0.5f);
+        uint16_t b = (uint16_t)(rgb[2] * 31.f / 255.f + 0.5f);
+        return (r << 11) | (g << 5) | b;
+    }
+
+    static void EncodeBC1Colors(const uint8_t* rgba, uint8_t* block)
+    {
+        float e0[3], e1[3];
+        GetAxisEndpoints(rgba, 3, e0, e1);
+
+        // inset a little so extremes don't dominate quantization
+        for(int c = 0; c < 3; c++)
+        {
+            float inset = (e1[c] - e0[c]) / 16.f;
+            e0[c] += inset;
+            e1[c] -= inset;
+        }
+
+        uint16_t c0 = Encode565(e1);
+        uint16_t c1 = Encode565(e0);
+        if(c0 < c1)
+        {
+            uint16_t swap = c0;
+            c0 = c1;
+            c1 = swap;
+        }
+
+        uint32_t indices = 0;
+        if(c0 != c1)
+        {
+            uint8_t palette[4][3];
+            Decode565(c0, palette[0]);
+            Decode565(c1, palette[1]);
+            for(int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for(int i = 0; i < 16; i++)
+            {
+                uint32_t best = 0;
+                int bestError = 1 << 30;
+                for(uint32_t p = 0; p < 4; p++)
+                {
+                    int error = 0;
+                    for(int c = 0; c < 3; c++)
+                    {
+                        int d = rgba[i * 4 + c] - palette[p][c];
+                        error += d * d;
+                    }
+                    if(error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= best << (i * 2);
+            }
+        }
+
+        block[0] = c0 & 0xFF;
+        block[1] = c0 >> 8;
+        block[2] = c1 & 0xFF;
+        block[3] = c1 >> 8;
+        block[4] = indices & 0xFF;
+        block[5] = (indices >> 8) & 0xFF;
+        block[6] = (indices >> 16) & 0xFF;
+        block[7] = indices >> 24;
+    }
+
+    // single channel read from every 4th byte of values
+    static void EncodeBC4Channel(const uint8_t* values, uint8_t* block)
+    {
+        uint8_t minValue = 255, maxValue = 0;
+        for(int i = 0; i < 16; i++)
+        {
+            uint8_t value = values[i * 4];
+            minValue = value < minValue ? value : minValue;
+            maxValue = value > maxValue ? value : maxValue;
+        }
+
+        block[0] = maxValue;
+        block[1] = minValue;
+        uint64_t indices = 0;
+        if(maxValue != minValue)
+        {
+            uint8_t palette[8];
+            palette[0] = maxValue;
+            palette[1] = minValue;
+            for(int i = 1; i < 7; i++)
+                palette[i + 1] = ((7 - i) * maxValue + i * minValue) / 7;
+
+            for(int i = 0; i < 16; i++)
+            {
+                uint64_t best = 0;
+                int bestError = 1 << 30;
+                for(uint32_t p = 0; p < 8; p++)
+                {
+                    int error = values[i * 4] - palette[p];
+                    error = error < 0 ? -error : error;
+                    if(error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= best << (i * 3);
+            }
+        }
+
+        for(int i = 0; i < 6; i++)
+            block[2 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+
+    struct BitWriter
+    {
+        uint8_t* data;
+        uint32_t position = 0;
+
+        void Write(uint32_t value, uint32_t count)
+        {
+            for(uint32_t i = 0; i < count; i++, position++)
+                data[position >> 3] |= ((value >> i) & 1u) << (position & 7);
+        }
+    };
+
+    // 7 bit endpoint + p bit, p bit chosen to minimize endpoint error
+    static void QuantizeBC7Mode6Endpoint(const float* endpoint, uint8_t* quantized, uint8_t& pBit)
+    {
+        int bestError = 1 << 30;
+        for(uint8_t p = 0; p < 2; p++)
+        {
+            uint8_t candidate[4];
+            int error = 0;
+            for(int c = 0; c < 4; c++)
+            {
+                int q = (int)((endpoint[c] - p) / 2.f + 0.5f);
+                q = q < 0 ? 0 : q > 127 ? 127 : q;
+                candidate[c] = (uint8_t)q;
+                int d = (int)endpoint[c] - ((q << 1) | p);
+                error += d * d;
+            }
+            if(error < bestError)
+            {
+                bestError = error;
+                pBit = p;
+                memcpy(quantized, candidate, 4);
+            }
+        }
+    }
+
+    static int FindBC7Mode6Indices(const uint8_t* rgba, const uint8_t* e0, const uint8_t* e1, uint8_t* indices)
+    {
+        uint8_t palette[16][4];
+        for(int p = 0; p < 16; p++)
+            for(int c = 0; c < 4; c++)
+                palette[p][c] = BC7Interpolate(e0[c], e1[c], BC7_WEIGHTS_4[p]);
+
+        int totalError = 0;
+        for(int i = 0; i < 16; i++)
+        {
+            int bestError = 1 << 30;
+            for(int p = 0; p < 16; p++)
+            {
+                int error = 0;
+                for(int c = 0; c < 4; c++)
+                {
+                    int d = rgba[i * 4 + c] - palette[p][c];
+                    error += d * d;
+                }
+                if(error < bestError)
+                {
+                    bestError = error;
+                    indices[i] = p;
+                }
+            }
+            totalError += bestError;
+        }
+        return totalError;
+    }
+
+    static void EncodeBC7Mode6(const uint8_t* rgba, uint8_t* block)
+    {
+        float endpoints[2][4];
+        GetAxisEndpoints(rgba, 4, endpoints[0], endpoints[1]);
+
+        uint8_t quantized[2][4], pBits[2], expanded[2][4], indices[16];
+        int bestError = 1 << 30;
+        uint8_t bestQuantized[2][4], bestPBits[2], bestIndices[16];
+
+        // second pass refits endpoints to chosen indices with least squares
+        for(int pass = 0; pass < 2; pass++)
+        {
+            for(int e = 0; e < 2; e++)
+            {
+                QuantizeBC7Mode6Endpoint(endpoints[e], quantized[e], pBits[e]);
+                for(int c = 0; c < 4; c++)
+                    expanded[e][c] = (quantized[e][c] << 1) | pBits[e];
+            }
+
+            int error = FindBC7Mode6Indices(rgba, expanded[0], expanded[1], indices);
+            if(error < bestError)
+            {
+                bestError = error;
+                memcpy(bestQuantized, quantized, sizeof(quantized));
+                memcpy(bestPBits, pBits, sizeof(pBits));
+                memcpy(bestIndices, indices, sizeof(indices));
+            }
+            if(pass == 1 || error == 0)
+                break;
+
+            float aa = 0.f, ab = 0.f, bb = 0.f;
+            float ax[4] = {}, bx[4] = {};
+            for(int i = 0; i < 16; i++)
+            {
+                float b = BC7_WEIGHTS_4[indices[i]] / 64.f;
+                float a = 1.f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for(int c = 0; c < 4; c++)
+                {
+                    ax[c] += a * rgba[i * 4 + c];
+                    bx[c] += b * rgba[i * 4 + c];
+                }
+            }
+            float determinant = aa * bb - ab * ab;
+            if(fabsf(determinant) < 1e-6f)
+                break;
+            for(int c = 0; c < 4; c++)
+            {
+                float v0 = (ax[c] * bb - bx[c] * ab) / determinant;
+                float v1 = (bx[c] * aa - ax[c] * ab) / determinant;
+                endpoints[0][c] = v0 < 0.f ? 0.f : v0 > 255.f ? 255.f : v0;
+                endpoints[1][c] = v1 < 0.f ? 0.f : v1 > 255.f ? 255.f : v1;
+            }
+        }
+
+        // anchor index is stored without its top bit, so it must be below 8
+        if(bestIndices[0] & 8)
+        {
+            for(int c = 0; c < 4; c++)
+            {
+                uint8_t swap = bestQuantized[0][c];
+                bestQuantized[0][c] = bestQuantized[1][c];
+                bestQuantized[1][c] = swap;
+            }
+            uint8_t swap = bestPBits[0];
+            bestPBits[0] = bestPBits[1];
+            bestPBits[1] = swap;
+            for(int i = 0; i < 16; i++)
+                bestIndices[i] = 15 - bestIndices[i];
+        }
+
+        memset(block, 0, 16);
+        BitWriter bits{ block };
+        bits.Write(1 << 6, 7);
+        for(int c = 0; c < 4; c++)
+        {
+            bits.Write(bestQuantized[0][c], 7);
+            bits.Write(bestQuantized[1][c], 7);
+        }
+        bits.Write(bestPBits[0], 1);
+        bits.Write(bestPBits[1], 1);
+        for(int i = 0; i < 16; i++)
+            bits.Write(bestIndices[i], i == 0 ? 3 : 4);
+    }
+
+    void EncodeBlock(BlockFormat format, const uint8_t* rgba, uint8_t* block)
+    {
+        switch(format)
+        {
+            case BlockFormat::BC1:
+                EncodeBC1Colors(rgba, block);
+                break;
+            case BlockFormat::BC3:
+                EncodeBC4Channel(rgba + 3, block);
+                EncodeBC1Colors(rgba, block + 8);
+                break;
+            case BlockFormat::BC5:
+                EncodeBC4Channel(rgba, block);
+                EncodeBC4Channel(rgba + 1, block + 8);
+                break;
+            case BlockFormat::BC7:
+                EncodeBC7Mode6(rgba, block);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void EncodeImage(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& data)
+    {
+        uint32_t blockSize = GetBlockSize(format);
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        data.assign(GetCompressedSize(format, width, height), 0);
+        if(width == 0 || height == 0)
+            return;
+
+        uint8_t pixels[64];
+        for(uint32_t by = 0; by < blocksY; by++)
+        {
+            for(uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                for(uint32_t y = 0; y < 4; y++)
+                {
+                    uint32_t sy = by * 4 + y < height ? by * 4 + y : height - 1;
+                    for(uint32_t x = 0; x < 4; x++)
+                    {
+                        uint32_t sx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+                        memcpy(pixels + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+                    }
+                }
+                EncodeBlock(format, pixels, data.data() + ((size_t)by * blocksX + bx) * blockSize);
+            }
+        }
+    }
+} // namespace nmGfx
@@ -0,0 +1,74 @@
+#ifndef __NM_GFX_BLOCK_COMPRESSION_HPP__
+#define __NM_GFX_BLOCK_COMPRESSION_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace nmGfx
+{
+    // 4x4 pixel block compressed formats
+    enum class BlockFormat
+    {
+        NONE = 0,
+        BC1, // rgb, 8 bytes per block
+        BC3, // rgba, 16 bytes per block
+        BC5, // two channel (normal maps), 16 bytes per block
+        BC7, // rgba high quality, 16 bytes per block
+    };
+
+    uint32_t GetBlockSize(BlockFormat format);
+    /**
+     * @brief Bytes of one compressed image, partial blocks on edges count as full blocks
+     *
+     */
+    size_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+    /**
+     * @brief Decodes one block into 4x4 rgba8 pixels, row by row
+     *
+     * BC5 is decoded as r, g, 0, 255. Invalid BC7 blocks decode as transparent black.
+     *
+     * @param format
+     * @param block
+     * @param rgba 64 bytes
+     */
+    void DecodeBlock(BlockFormat format, const uint8_t* block, uint8_t* rgba);
+
+    /**
+     * @brief Decodes compressed image into rgba8 pixels
+     *
+     * @param format
+     * @param data GetCompressedSize(format, width, height) bytes
+     * @param width
+     * @param height
+     * @param rgba width * height * 4 bytes
+     */
+    void DecodeImage(BlockFormat format, const uint8_t* data, uint32_t width, uint32_t height, uint8_t* rgba);
+
+    /**
+     * @brief Encodes 4x4 rgba8 pixels into one block
+     *
+     * BC1 is encoded opaque, BC5 encodes r and g. BC7 uses single subset mode 6 only.
+     *
+     * @param format
+     * @param rgba 64 bytes, row by row
+     * @param block
+     */
+    void EncodeBlock(BlockFormat format, const uint8_t* rgba, uint8_t* block);
+
+    /**
+     * @brief Encodes rgba8 image, edges of partial blocks are clamped
+     *
+     * @param format
+     * @param rgba width * height * 4 bytes
+     * @param width
+     * @param height
+     * @param data resized to GetCompressedSize(format, width, height)
+     */
+    void EncodeImage(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& data);
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_BLOCK_COMPRESSION_HPP__
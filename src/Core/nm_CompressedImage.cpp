@@ -0,0 +1,382 @@
+#include "nm_CompressedImage.hpp"
+#include <stdio.h>
+#include <string.h>
+
+namespace nmGfx
+{
+    static const uint8_t KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    static const uint32_t DDS_HEADER_SIZE = 124;
+    static const uint32_t DDS_DX10_HEADER_SIZE = 20;
+    static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    static const uint32_t DDSD_DEPTH = 0x800000;
+    static const uint32_t DDPF_FOURCC = 0x4;
+    static const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+
+    static inline uint32_t ReadU32(const uint8_t* p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static inline uint64_t ReadU64(const uint8_t* p)
+    {
+        return ReadU32(p) | ((uint64_t)ReadU32(p + 4) << 32);
+    }
+
+    static inline uint32_t FourCC(const char* code)
+    {
+        return ReadU32((const uint8_t*)code);
+    }
+
+    static BlockFormat GetFormatFromFourCC(uint32_t fourCC)
+    {
+        return fourCC == FourCC("DXT1") ? BlockFormat::BC1
+            : fourCC == FourCC("DXT5") ? BlockFormat::BC3
+            : fourCC == FourCC("ATI2") ? BlockFormat::BC5
+            : fourCC == FourCC("BC5U") ? BlockFormat::BC5
+            : BlockFormat::NONE;
+    }
+
+    static BlockFormat GetFormatFromDXGI(uint32_t format)
+    {
+        return format >= 70 && format <= 72 ? BlockFormat::BC1
+            : format >= 76 && format <= 78 ? BlockFormat::BC3
+            : format >= 82 && format <= 83 ? BlockFormat::BC5
+            : format >= 97 && format <= 99 ? BlockFormat::BC7
+            : BlockFormat::NONE;
+    }
+
+    static bool IsSRGBDXGI(uint32_t format)
+    {
+        // DXGI_FORMAT_BC1/BC3/BC7_UNORM_SRGB
+        return format == 72 || format == 78 || format == 99;
+    }
+
+    static BlockFormat GetFormatFromGLInternalFormat(uint32_t format)
+    {
+        return format == 0x83F0 || format == 0x83F1 ? BlockFormat::BC1 // GL_COMPRESSED_RGB(A)_S3TC_DXT1_EXT
+            : format == 0x8C4C || format == 0x8C4D ? BlockFormat::BC1   // GL_COMPRESSED_SRGB(_ALPHA)_S3TC_DXT1_EXT
+            : format == 0x83F3 ? BlockFormat::BC3                       // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+            : format == 0x8C4F ? BlockFormat::BC3                       // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+            : format == 0x8DBD ? BlockFormat::BC5                       // GL_COMPRESSED_RG_RGTC2
+            : format == 0x8E8C || format == 0x8E8D ? BlockFormat::BC7   // GL_COMPRESSED_(RGBA/SRGB_ALPHA)_BPTC_UNORM
+            : BlockFormat::NONE;
+    }
+
+    static bool IsSRGBGLInternalFormat(uint32_t format)
+    {
+        return format == 0x8C4C || format == 0x8C4D || format == 0x8C4F || format == 0x8E8D;
+    }
+
+    static BlockFormat GetFormatFromVkFormat(uint32_t format)
+    {
+        return format >= 131 && format <= 134 ? BlockFormat::BC1
+            : format >= 137 && format <= 138 ? BlockFormat::BC3
+            : format == 141 ? BlockFormat::BC5
+            : format >= 145 && format <= 146 ? BlockFormat::BC7
+            : BlockFormat::NONE;
+    }
+
+    static bool IsSRGBVkFormat(uint32_t format)
+    {
+        // VK_FORMAT_BC1_RGB/BC1_RGBA/BC3/BC7_SRGB_BLOCK
+        return format == 132 || format == 134 || format == 138 || format == 146;
+    }
+
+    // floor(log2(max(width, height))) + 1, levels past 1x1 can't exist
+    static uint32_t GetMaxLevelCount(uint32_t width, uint32_t height)
+    {
+        uint32_t size = width > height ? width : height;
+        uint32_t count = 1;
+        while(size > 1)
+        {
+            size >>= 1;
+            count++;
+        }
+        return count;
+    }
+
+    bool CompressedImage::LoadFromFile(const char* path)
+    {
+        _data = nullptr;
+        _size = 0;
+        if(!_file.Open(path))
+        {
+#ifdef NMGFX_PRINT_MESSAGES
+            printf("Error: Failed to open compressed image: %s\n", path);
+#endif
+            return false;
+        }
+
+        _data = _file.Data();
+        _size = _file.Size();
+        if(!Parse())
+        {
+#ifdef NMGFX_PRINT_MESSAGES
+            printf("Error: Unsupported or invalid compressed image: %s\n", path);
+#endif
+            _file.Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool CompressedImage::LoadFromMemory(const uint8_t* data, size_t size)
+    {
+        _file.Close();
+        _data = data;
+        _size = size;
+        return Parse();
+    }
+
+    bool CompressedImage::Parse()
+    {
+        _format = BlockFormat::NONE;
+        _srgb = false;
+        _levels.clear();
+
+        bool parsed = false;
+        if(_size >= 4 && memcmp(_data, "DDS ", 4) == 0)
+            parsed = ParseDDS();
+        else if(_size >= 12 && memcmp(_data, KTX_IDENTIFIER, 12) == 0)
+            parsed = ParseKTX();
+        else if(_size >= 12 && memcmp(_data, KTX2_IDENTIFIER, 12) == 0)
+            parsed = ParseKTX2();
+
+        if(!parsed || _levels.empty())
+        {
+            _format = BlockFormat::NONE;
+            _srgb = false;
+            _levels.clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool CompressedImage::AddLevel(uint32_t width, uint32_t height, uint64_t offset, uint64_t size)
+    {
+        if(width == 0 || height == 0 || size != GetCompressedSize(_format, width, height))
+            return false;
+        if(offset > _size || size > _size - offset)
+            return false;
+
+        _levels.push_back({ width, height, (size_t)offset, (size_t)size });
+        return true;
+    }
+
+    bool CompressedImage::ParseDDS()
+    {
+        if(_size < 4 + DDS_HEADER_SIZE)
+            return false;
+
+        const uint8_t* header = _data + 4;
+        uint32_t flags = ReadU32(header + 4);
+        uint32_t height = ReadU32(header + 8);
+        uint32_t width = ReadU32(header + 12);
+        uint32_t mipCount = ReadU32(header + 24);
+        uint32_t pixelFormatFlags = ReadU32(header + 76);
+        uint32_t fourCC = ReadU32(header + 80);
+        uint32_t caps2 = ReadU32(header + 108);
+
+        if(ReadU32(header) != DDS_HEADER_SIZE || !(pixelFormatFlags & DDPF_FOURCC))
+            return false;
+        if((flags & DDSD_DEPTH) || (caps2 & DDSCAPS2_CUBEMAP))
+            return false;
+
+        uint64_t offset = 4 + DDS_HEADER_SIZE;
+        if(fourCC == FourCC("DX10"))
+        {
+            if(_size < offset + DDS_DX10_HEADER_SIZE)
+                return false;
+
+            const uint8_t* dx10 = _data + offset;
+            uint32_t resourceDimension = ReadU32(dx10 + 4);
+            uint32_t arraySize = ReadU32(dx10 + 12);
+            // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+            if(resourceDimension != 3 || arraySize > 1)
+                return false;
+
+            _format = GetFormatFromDXGI(ReadU32(dx10));
+            _srgb = IsSRGBDXGI(ReadU32(dx10));
+            offset += DDS_DX10_HEADER_SIZE;
+        }
+        else
+            _format = GetFormatFromFourCC(fourCC);
+
+        if(_format == BlockFormat::NONE)
+            return false;
+
+        uint32_t levelCount = (flags & DDSD_MIPMAPCOUNT) && mipCount > 0 ? mipCount : 1;
+        for(uint32_t level = 0; level < levelCount; level++)
+        {
+            uint32_t levelWidth = width >> level > 0 ? width >> level : 1;
+            uint32_t levelHeight = height >> level > 0 ? height >> level : 1;
+            uint64_t size = GetCompressedSize(_format, levelWidth, levelHeight);
+            if(!AddLevel(levelWidth, levelHeight, offset, size))
+                return false;
+
+            offset += size;
+            if(levelWidth == 1 && levelHeight == 1)
+                break;
+        }
+        return true;
+    }
+
+    bool CompressedImage::ParseKTX()
+    {
+        if(_size < 64)
+            return false;
+
+        // files written on big endian machines store 0x01020304 here
+        if(ReadU32(_data + 12) != 0x04030201)
+            return false;
+
+        uint32_t glType = ReadU32(_data + 16);
+        uint32_t width = ReadU32(_data + 36);
+        uint32_t height = ReadU32(_data + 40);
+        uint32_t depth = ReadU32(_data + 44);
+        uint32_t arrayElements = ReadU32(_data + 48);
+        uint32_t faces = ReadU32(_data + 52);
+        uint32_t mipCount = ReadU32(_data + 56);
+        uint32_t keyValueBytes = ReadU32(_data + 60);
+
+        if(glType != 0 || depth > 1 || arrayElements > 0 || faces != 1)
+            return false;
+
+        _format = GetFormatFromGLInternalFormat(ReadU32(_data + 28));
+        _srgb = IsSRGBGLInternalFormat(ReadU32(_data + 28));
+        if(_format == BlockFormat::NONE)
+            return false;
+
+        uint64_t offset = 64 + (uint64_t)keyValueBytes;
+        uint32_t levelCount = mipCount > 0 ? mipCount : 1;
+        if(levelCount > GetMaxLevelCount(width, height))
+            levelCount = GetMaxLevelCount(width, height);
+        for(uint32_t level = 0; level < levelCount; level++)
+        {
+            if(offset + 4 > _size)
+                return false;
+
+            uint32_t size = ReadU32(_data + offset);
+            offset += 4;
+
+            uint32_t levelWidth = width >> level > 0 ? width >> level : 1;
+            uint32_t levelHeight = height >> level > 0 ? height >> level : 1;
+            if(!AddLevel(levelWidth, levelHeight, offset, size))
+                return false;
+
+            // mip padding to 4 bytes
+            offset += (size + 3) & ~3u;
+        }
+        return true;
+    }
+
+    bool CompressedImage::ParseKTX2()
+    {
+        if(_size < 80)
+            return false;
+
+        uint32_t vkFormat = ReadU32(_data + 12);
+        uint32_t width = ReadU32(_data + 20);
+        uint32_t height = ReadU32(_data + 24);
+        uint32_t depth = ReadU32(_data + 28);
+        uint32_t layers = ReadU32(_data + 32);
+        uint32_t faces = ReadU32(_data + 36);
+        uint32_t levelCount = ReadU32(_data + 40);
+        uint32_t supercompression = ReadU32(_data + 44);
+
+        // basis and zstd supercompression need a transcoder
+        if(supercompression != 0 || depth > 1 || layers > 0 || faces != 1)
+            return false;
+
+        _format = GetFormatFromVkFormat(vkFormat);
+        _srgb = IsSRGBVkFormat(vkFormat);
+        if(_format == BlockFormat::NONE)
+            return false;
+
+        levelCount = levelCount > 0 ? levelCount : 1;
+        if(levelCount > GetMaxLevelCount(width, height))
+            levelCount = GetMaxLevelCount(width, height);
+        if(80 + (uint64_t)levelCount * 24 > _size)
+            return false;
+
+        for(uint32_t level = 0; level < levelCount; level++)
+        {
+            const uint8_t* index = _data + 80 + level * 24;
+            uint32_t levelWidth = width >> level > 0 ? width >> level : 1;
+            uint32_t levelHeight = height >> level > 0 ? height >> level : 1;
+            if(!AddLevel(levelWidth, levelHeight, ReadU64(index), ReadU64(index + 8)))
+                return false;
+        }
+        return true;
+    }
+
+    static void WriteU32(FILE* file, uint32_t value)
+    {
+        uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+        fwrite(bytes, 1, 4, file);
+    }
+
+    bool CompressedImage::WriteDDS(const char* path, BlockFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels)
+    {
+        if(format == BlockFormat::NONE || levels.empty())
+            return false;
+
+        FILE* file = fopen(path, "wb");
+        if(file == nullptr)
+            return false;
+
+        uint32_t fourCC = format == BlockFormat::BC1 ? FourCC("DXT1")
+            : format == BlockFormat::BC3 ? FourCC("DXT5")
+            : format == BlockFormat::BC5 ? FourCC("ATI2")
+            : FourCC("DX10");
+
+        // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE
+        uint32_t flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000;
+        // DDSCAPS_TEXTURE, plus DDSCAPS_COMPLEX | DDSCAPS_MIPMAP with mips
+        uint32_t caps = 0x1000;
+        if(levels.size() > 1)
+        {
+            flags |= DDSD_MIPMAPCOUNT;
+            caps |= 0x8 | 0x400000;
+        }
+
+        fwrite("DDS ", 1, 4, file);
+        WriteU32(file, DDS_HEADER_SIZE);
+        WriteU32(file, flags);
+        WriteU32(file, height);
+        WriteU32(file, width);
+        WriteU32(file, (uint32_t)levels[0].size());
+        WriteU32(file, 0); // depth
+        WriteU32(file, (uint32_t)levels.size());
+        for(int i = 0; i < 11; i++)
+            WriteU32(file, 0);
+
+        // pixel format
+        WriteU32(file, 32);
+        WriteU32(file, DDPF_FOURCC);
+        WriteU32(file, fourCC);
+        for(int i = 0; i < 5; i++)
+            WriteU32(file, 0);
+
+        WriteU32(file, caps);
+        for(int i = 0; i < 4; i++)
+            WriteU32(file, 0);
+
+        if(fourCC == FourCC("DX10"))
+        {
+            WriteU32(file, 98); // DXGI_FORMAT_BC7_UNORM
+            WriteU32(file, 3);  // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+            WriteU32(file, 0);
+            WriteU32(file, 1);
+            WriteU32(file, 0);
+        }
+
+        bool success = true;
+        for(const std::vector<uint8_t>& level : levels)
+            success = success && fwrite(level.data(), 1, level.size(), file) == level.size();
+
+        return fclose(file) == 0 && success;
+    }
+} // namespace nmGfx
@@ -0,0 +1,88 @@
+#ifndef __NM_GFX_COMPRESSED_IMAGE_HPP__
+#define __NM_GFX_COMPRESSED_IMAGE_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "nm_BlockCompression.hpp"
+#include "nm_MappedFile.hpp"
+
+namespace nmGfx
+{
+    struct CompressedLevel
+    {
+        uint32_t width;
+        uint32_t height;
+        size_t offset; // from start of file
+        size_t size;
+    };
+
+    /**
+     * @brief Block compressed 2d image with its mip chain, read from DDS, KTX or KTX2 files
+     *
+     * Supported formats are BC1, BC3, BC5 and BC7, sRGB variants are reported by IsSRGB. Cubemaps,
+     * arrays, volume textures and supercompressed KTX2 files are rejected. Rows are used in file
+     * order, files written by nmTextureEncoder are already flipped for gl.
+     */
+    class CompressedImage
+    {
+        public:
+            CompressedImage() = default;
+            CompressedImage(const CompressedImage&) = delete;
+            CompressedImage& operator=(const CompressedImage&) = delete;
+
+            /**
+             * @brief Maps file and validates header and every level
+             *
+             * @param path
+             * @return true if file is a supported compressed image
+             */
+            bool LoadFromFile(const char* path);
+            /**
+             * @brief Same as LoadFromFile, data isn't copied and must outlive the image
+             *
+             */
+            bool LoadFromMemory(const uint8_t* data, size_t size);
+
+            inline BlockFormat GetFormat() const { return _format; }
+            // Texels are sRGB encoded, BC1, BC3 and BC7 only
+            inline bool IsSRGB() const { return _srgb; }
+            inline uint32_t GetWidth() const { return _levels.empty() ? 0 : _levels[0].width; }
+            inline uint32_t GetHeight() const { return _levels.empty() ? 0 : _levels[0].height; }
+            inline uint32_t GetLevelCount() const { return (uint32_t)_levels.size(); }
+            inline const CompressedLevel& GetLevel(uint32_t level) const { return _levels[level]; }
+            inline const uint8_t* GetLevelData(uint32_t level) const { return _data + _levels[level].offset; }
+
+            /**
+             * @brief Writes levels as DDS, BC7 uses DX10 header
+             *
+             * @param path
+             * @param format
+             * @param width of first level
+             * @param height of first level
+             * @param levels compressed data of each mip level, largest first
+             * @return true on success
+             */
+            static bool WriteDDS(const char* path, BlockFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels);
+
+        private:
+            bool Parse();
+            bool ParseDDS();
+            bool ParseKTX();
+            bool ParseKTX2();
+            bool AddLevel(uint32_t width, uint32_t height, uint64_t offset, uint64_t size);
+
+            MappedFile _file;
+            const uint8_t* _data = nullptr;
+            size_t _size = 0;
+
+            BlockFormat _format = BlockFormat::NONE;
+            bool _srgb = false;
+            std::vector<CompressedLevel> _levels;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_COMPRESSED_IMAGE_HPP__
@@ -0,0 +1,105 @@
+#include "nm_MappedFile.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+namespace nmGfx
+{
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    bool MappedFile::Open(const char* path)
+    {
+        Close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping == nullptr)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(data == nullptr)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        _file = file;
+        _mapping = mapping;
+        _data = (const unsigned char*)data;
+        _size = (size_t)size.QuadPart;
+#else
+        int fd = open(path, O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        struct stat st;
+        if(fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // mapping stays valid after descriptor is closed
+        close(fd);
+        if(data == MAP_FAILED)
+            return false;
+
+        _data = (const unsigned char*)data;
+        _size = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if(_data == nullptr)
+            return;
+
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+        CloseHandle((HANDLE)_mapping);
+        CloseHandle((HANDLE)_file);
+        _mapping = nullptr;
+        _file = nullptr;
+#else
+        munmap((void*)_data, _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    int64_t MappedFile::GetModifiedTime(const char* path)
+    {
+        struct stat st;
+        if(stat(path, &st) != 0)
+            return 0;
+        return (int64_t)st.st_mtime;
+    }
+} // namespace nmGfx
@@ -0,0 +1,49 @@
+#ifndef __NM_GFX_MAPPED_FILE_HPP__
+#define __NM_GFX_MAPPED_FILE_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace nmGfx
+{
+    /**
+     * @brief Read only memory mapped file, unmapped on Close or destruction
+     *
+     */
+    class MappedFile
+    {
+        public:
+            MappedFile() = default;
+            ~MappedFile();
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            bool Open(const char* path);
+            void Close();
+
+            inline bool IsOpen() const { return _data != nullptr; }
+            inline const unsigned char* Data() const { return _data; }
+            inline size_t Size() const { return _size; }
+
+            /**
+             * @brief Last modification time of file in seconds, 0 if it doesn't exist
+             *
+             * @param path
+             * @return int64_t
+             */
+            static int64_t GetModifiedTime(const char* path);
+
+        private:
+            const unsigned char* _data = nullptr;
+            size_t _size = 0;
+
+#ifdef _WIN32
+            void* _file = nullptr;
+            void* _mapping = nullptr;
+#endif
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_MAPPED_FILE_HPP__
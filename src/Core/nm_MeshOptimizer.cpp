@@ -0,0 +1,330 @@
+#include "nm_MeshOptimizer.hpp"
+#include <math.h>
+#include <algorithm>
+#include "glm/glm.hpp"
+
+namespace nmGfx
+{
+    static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+    // forsyth, "Linear-Speed Vertex Cache Optimisation"
+    static const uint32_t FORSYTH_CACHE_SIZE = 32;
+    static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+    static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+    static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+    static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+    static float ForsythVertexScore(int cachePosition, uint32_t remainingTriangles)
+    {
+        if(remainingTriangles == 0)
+            return -1.f;
+
+        float score = 0.f;
+        if(cachePosition >= 0)
+        {
+            if(cachePosition < 3)
+            {
+                // vertices of last triangle get a fixed score so the next triangle doesn't just reuse the same edge
+                score = FORSYTH_LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                float scaler = 1.f / (FORSYTH_CACHE_SIZE - 3);
+                score = powf(1.f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+            }
+        }
+
+        // favour vertices with few triangles left so they don't get stranded
+        score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    float CalculateACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        uint32_t triangleCount = indices.size() / 3;
+        if(triangleCount == 0)
+            return 0.f;
+
+        // vertex is in cache if it was transformed less than cacheSize misses ago
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        uint32_t misses = 0;
+        for(uint32_t index : indices)
+        {
+            if(time - timestamps[index] > cacheSize)
+            {
+                timestamps[index] = time++;
+                misses++;
+            }
+        }
+        return (float)misses / triangleCount;
+    }
+
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+    {
+        uint32_t triangleCount = indices.size() / 3;
+        if(triangleCount == 0)
+            return;
+
+        // vertex -> triangle adjacency, remaining triangles of each vertex are kept at front of its range
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for(uint32_t index : indices)
+            remaining[index]++;
+
+        std::vector<uint32_t> offsets(vertexCount, 0);
+        uint32_t offset = 0;
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            offsets[v] = offset;
+            offset += remaining[v];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> fill(vertexCount, 0);
+        for(uint32_t t = 0; t < triangleCount; t++)
+        {
+            for(uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t v = indices[t * 3 + k];
+                adjacency[offsets[v] + fill[v]++] = t;
+            }
+        }
+
+        std::vector<int> cachePositions(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for(uint32_t v = 0; v < vertexCount; v++)
+            vertexScores[v] = ForsythVertexScore(-1, remaining[v]);
+
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        uint32_t best = INVALID_INDEX;
+        float bestScore = -1.f;
+        for(uint32_t t = 0; t < triangleCount; t++)
+        {
+            triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+            if(triangleScores[t] > bestScore)
+            {
+                bestScore = triangleScores[t];
+                best = t;
+            }
+        }
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> newCache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+        uint32_t cursor = 0;
+
+        for(uint32_t i = 0; i < triangleCount; i++)
+        {
+            if(best == INVALID_INDEX)
+            {
+                // nothing adjacent to cache left, continue from next triangle in input order
+                while(emitted[cursor])
+                    cursor++;
+                best = cursor;
+            }
+
+            emitted[best] = true;
+            const uint32_t* triangle = &indices[best * 3];
+            result.insert(result.end(), triangle, triangle + 3);
+
+            newCache.clear();
+            for(uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t v = triangle[k];
+
+                uint32_t* begin = &adjacency[offsets[v]];
+                uint32_t* end = begin + remaining[v];
+                uint32_t* it = std::find(begin, end, best);
+                if(it != end)
+                {
+                    *it = *(end - 1);
+                    remaining[v]--;
+                }
+
+                if(std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+                    newCache.push_back(v);
+            }
+            for(uint32_t v : cache)
+            {
+                if(std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+                    newCache.push_back(v);
+            }
+
+            // vertices pushed past the end fall out of cache but their score still changes
+            for(uint32_t c = 0; c < newCache.size(); c++)
+            {
+                uint32_t v = newCache[c];
+                cachePositions[v] = c < FORSYTH_CACHE_SIZE ? (int)c : -1;
+
+                float score = ForsythVertexScore(cachePositions[v], remaining[v]);
+                float delta = score - vertexScores[v];
+                vertexScores[v] = score;
+                for(uint32_t a = 0; a < remaining[v]; a++)
+                    triangleScores[adjacency[offsets[v] + a]] += delta;
+            }
+
+            best = INVALID_INDEX;
+            bestScore = -1.f;
+            uint32_t cacheCount = std::min<uint32_t>(newCache.size(), FORSYTH_CACHE_SIZE);
+            for(uint32_t c = 0; c < cacheCount; c++)
+            {
+                uint32_t v = newCache[c];
+                for(uint32_t a = 0; a < remaining[v]; a++)
+                {
+                    uint32_t t = adjacency[offsets[v] + a];
+                    if(triangleScores[t] > bestScore)
+                    {
+                        bestScore = triangleScores[t];
+                        best = t;
+                    }
+                }
+            }
+
+            newCache.resize(cacheCount);
+            cache.swap(newCache);
+        }
+
+        indices.swap(result);
+    }
+
+    void OptimizeOverdraw(std::vector<uint32_t>& indices, const float* positions, uint32_t vertexCount, uint32_t stride, float threshold)
+    {
+        uint32_t triangleCount = indices.size() / 3;
+        if(triangleCount < 2)
+            return;
+
+        float acmrBefore = CalculateACMR(indices, vertexCount);
+
+        // cluster boundaries where the cache was flushed, triangles in between share vertices and must stay together
+        const uint32_t cacheSize = 16;
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        std::vector<uint32_t> clusterStarts;
+        for(uint32_t t = 0; t < triangleCount; t++)
+        {
+            uint32_t misses = 0;
+            for(uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t index = indices[t * 3 + k];
+                if(time - timestamps[index] > cacheSize)
+                {
+                    timestamps[index] = time++;
+                    misses++;
+                }
+            }
+            if(t == 0 || misses == 3)
+                clusterStarts.push_back(t);
+        }
+        if(clusterStarts.size() < 2)
+            return;
+
+        struct Cluster
+        {
+            uint32_t start;
+            uint32_t count;
+            glm::vec3 centroid;
+            glm::vec3 normal;
+            float sortKey;
+        };
+
+        std::vector<Cluster> clusters(clusterStarts.size());
+        glm::vec3 meshCentroid(0.f);
+        float meshArea = 0.f;
+        for(uint32_t c = 0; c < clusters.size(); c++)
+        {
+            Cluster& cluster = clusters[c];
+            cluster.start = clusterStarts[c];
+            cluster.count = (c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount) - cluster.start;
+            cluster.centroid = glm::vec3(0.f);
+            cluster.normal = glm::vec3(0.f);
+
+            float clusterArea = 0.f;
+            for(uint32_t t = cluster.start; t < cluster.start + cluster.count; t++)
+            {
+                const float* p0 = positions + indices[t * 3 + 0] * stride;
+                const float* p1 = positions + indices[t * 3 + 1] * stride;
+                const float* p2 = positions + indices[t * 3 + 2] * stride;
+                glm::vec3 a(p0[0], p0[1], p0[2]);
+                glm::vec3 b(p1[0], p1[1], p1[2]);
+                glm::vec3 d(p2[0], p2[1], p2[2]);
+
+                // area weighted
+                glm::vec3 n = glm::cross(b - a, d - a);
+                float area = glm::length(n);
+                cluster.normal += n;
+                cluster.centroid += (a + b + d) * (area / 3.f);
+                clusterArea += area;
+            }
+
+            meshCentroid += cluster.centroid;
+            meshArea += clusterArea;
+            if(clusterArea > 0.f)
+                cluster.centroid /= clusterArea;
+        }
+        if(meshArea > 0.f)
+            meshCentroid /= meshArea;
+
+        for(Cluster& cluster : clusters)
+        {
+            float normalLength = glm::length(cluster.normal);
+            glm::vec3 normal = normalLength > 0.f ? cluster.normal / normalLength : glm::vec3(0.f);
+            cluster.sortKey = glm::dot(cluster.centroid - meshCentroid, normal);
+        }
+
+        // clusters facing away from center are most likely to occlude the rest
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for(const Cluster& cluster : clusters)
+            result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + (cluster.start + cluster.count) * 3);
+
+        if(CalculateACMR(result, vertexCount) <= acmrBefore * threshold)
+            indices.swap(result);
+    }
+
+    uint32_t OptimizeVertexFetch(std::vector<float>& vertices, uint32_t stride, std::vector<uint32_t>& indices)
+    {
+        uint32_t vertexCount = vertices.size() / stride;
+
+        std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+        uint32_t next = 0;
+        for(uint32_t& index : indices)
+        {
+            if(remap[index] == INVALID_INDEX)
+                remap[index] = next++;
+            index = remap[index];
+        }
+
+        std::vector<float> result((size_t)next * stride);
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            if(remap[v] != INVALID_INDEX)
+                std::copy(vertices.begin() + (size_t)v * stride, vertices.begin() + (size_t)(v + 1) * stride, result.begin() + (size_t)remap[v] * stride);
+        }
+
+        vertices.swap(result);
+        return next;
+    }
+
+    MeshOptimizeStats OptimizeMesh(std::vector<float>& vertices, uint32_t stride, std::vector<uint32_t>& indices, const MeshOptimizeSettings& settings)
+    {
+        MeshOptimizeStats stats;
+        uint32_t vertexCount = vertices.size() / stride;
+        stats.acmrBefore = CalculateACMR(indices, vertexCount);
+
+        if(settings.vertexCache)
+            OptimizeVertexCache(indices, vertexCount);
+        if(settings.overdraw)
+            OptimizeOverdraw(indices, vertices.data(), vertexCount, stride, settings.overdrawThreshold);
+        if(settings.vertexFetch)
+            vertexCount = OptimizeVertexFetch(vertices, stride, indices);
+
+        stats.acmrAfter = CalculateACMR(indices, vertexCount);
+        return stats;
+    }
+} // namespace nmGfx
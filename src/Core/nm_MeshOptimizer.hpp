@@ -0,0 +1,82 @@
+#ifndef __NM_GFX_MESH_OPTIMIZER_HPP__
+#define __NM_GFX_MESH_OPTIMIZER_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace nmGfx
+{
+    struct MeshOptimizeSettings
+    {
+        // reorder triangles for post-transform vertex cache (forsyth)
+        bool vertexCache = true;
+        // sort cache-friendly triangle clusters front to back from outside, can cost a little cache efficiency
+        bool overdraw = false;
+        // overdraw pass is discarded if it makes acmr worse than this factor
+        float overdrawThreshold = 1.05f;
+        // reorder vertex buffer by first use and drop unreferenced vertices
+        bool vertexFetch = true;
+    };
+
+    struct MeshOptimizeStats
+    {
+        float acmrBefore = 0.f;
+        float acmrAfter = 0.f;
+    };
+
+    /**
+     * @brief Average cache miss ratio, transformed vertices per triangle with a fifo cache. 0.5 is ideal, 3 is no reuse at all
+     *
+     * @param indices triangle list
+     * @param vertexCount
+     * @param cacheSize
+     * @return float
+     */
+    float CalculateACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+    /**
+     * @brief Reorders triangles so consecutive triangles share recently transformed vertices
+     *
+     * @param indices triangle list, reordered in place
+     * @param vertexCount
+     */
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+    /**
+     * @brief Splits triangle list into clusters at vertex cache flushes and orders clusters so outward facing ones are drawn first
+     *
+     * Run after OptimizeVertexCache.
+     *
+     * @param indices triangle list, reordered in place
+     * @param positions first 3 floats of each vertex are used as position
+     * @param vertexCount
+     * @param stride vertex size in floats
+     * @param threshold result is discarded if acmr grows more than this factor
+     */
+    void OptimizeOverdraw(std::vector<uint32_t>& indices, const float* positions, uint32_t vertexCount, uint32_t stride, float threshold = 1.05f);
+
+    /**
+     * @brief Reorders vertices in order of first use and remaps indices. Unreferenced vertices are removed
+     *
+     * @param vertices interleaved vertex data
+     * @param stride vertex size in floats
+     * @param indices
+     * @return uint32_t new vertex count
+     */
+    uint32_t OptimizeVertexFetch(std::vector<float>& vertices, uint32_t stride, std::vector<uint32_t>& indices);
+
+    /**
+     * @brief Runs enabled passes in order: vertex cache, overdraw, vertex fetch
+     *
+     * @param vertices interleaved vertex data, first 3 floats of each vertex are position
+     * @param stride vertex size in floats
+     * @param indices triangle list
+     * @param settings
+     * @return MeshOptimizeStats acmr before and after
+     */
+    MeshOptimizeStats OptimizeMesh(std::vector<float>& vertices, uint32_t stride, std::vector<uint32_t>& indices, const MeshOptimizeSettings& settings = MeshOptimizeSettings());
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_MESH_OPTIMIZER_HPP__
@@ -0,0 +1,389 @@
+#include "nm_ObjParser.hpp"
+#include <stdio.h>
+#include <string.h>
+
+#include "tiny_obj_loader.h"
+#include "nm_MappedFile.hpp"
+
+namespace nmGfx
+{
+    // smaller chunks balance better, larger ones cost less to merge
+    static const size_t OBJ_MIN_CHUNK_SIZE = 256 * 1024;
+    static const uint32_t INVALID_VERTEX = 0xFFFFFFFF;
+
+    struct ObjCorner
+    {
+        int vertex;
+        int texcoord;
+        int normal;
+        // bit per index that is relative to its chunk instead of absolute
+        uint8_t relative;
+    };
+
+    struct ObjChunk
+    {
+        const char* begin;
+        const char* end;
+
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texcoords;
+        std::vector<ObjCorner> corners; // 3 per triangle
+        bool valid = true;
+    };
+
+    static inline bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static inline void SkipSpaces(const char*& p, const char* end)
+    {
+        while(p < end && IsSpace(*p))
+            p++;
+    }
+
+    static inline int ParseInt(const char*& p, const char* end)
+    {
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        int value = 0;
+        while(p < end && *p >= '0' && *p <= '9')
+            value = value * 10 + (*p++ - '0');
+        return negative ? -value : value;
+    }
+
+    static inline float ParseFloat(const char*& p, const char* end)
+    {
+        static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        SkipSpaces(p, end);
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        // digits past 19 don't fit mantissa and can't change a float
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        while(p < end && *p >= '0' && *p <= '9')
+        {
+            if(digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                if(mantissa != 0)
+                    digits++;
+            }
+            else
+                exponent++;
+            p++;
+        }
+        if(p < end && *p == '.')
+        {
+            p++;
+            while(p < end && *p >= '0' && *p <= '9')
+            {
+                if(digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    if(mantissa != 0)
+                        digits++;
+                    exponent--;
+                }
+                p++;
+            }
+        }
+        if(p < end && (*p == 'e' || *p == 'E'))
+        {
+            p++;
+            exponent += ParseInt(p, end);
+        }
+
+        double value = (double)mantissa;
+        while(exponent > 22)
+        {
+            value *= powers[22];
+            exponent -= 22;
+        }
+        while(exponent < -22)
+        {
+            value /= powers[22];
+            exponent += 22;
+        }
+        value = exponent >= 0 ? value * powers[exponent] : value / powers[-exponent];
+
+        // skip rest of token, e.g. "nan" or garbage
+        while(p < end && !IsSpace(*p) && *p != '\n')
+            p++;
+
+        return (float)(negative ? -value : value);
+    }
+
+    static inline bool ParseIndex(const char*& p, const char* end, int count, uint8_t bit, uint8_t& relative, int& index)
+    {
+        // 0 and missing digits both parse as 0, which is invalid like in tinyobj
+        int value = ParseInt(p, end);
+        if(value == 0)
+            return false;
+
+        if(value > 0)
+        {
+            index = value - 1;
+            return true;
+        }
+        relative |= bit;
+        index = count + value;
+        return true;
+    }
+
+    static void ParseObjChunk(ObjChunk& chunk)
+    {
+        const char* p = chunk.begin;
+        const char* end = chunk.end;
+        std::vector<ObjCorner> face;
+
+        while(p < end)
+        {
+            const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+            if(lineEnd == nullptr)
+                lineEnd = end;
+
+            SkipSpaces(p, lineEnd);
+            if(lineEnd - p >= 2 && p[0] == 'v' && IsSpace(p[1]))
+            {
+                p += 2;
+                for(int i = 0; i < 3; i++)
+                    chunk.positions.push_back(ParseFloat(p, lineEnd));
+            }
+            else if(lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+            {
+                p += 3;
+                for(int i = 0; i < 3; i++)
+                    chunk.normals.push_back(ParseFloat(p, lineEnd));
+            }
+            else if(lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+            {
+                p += 3;
+                for(int i = 0; i < 2; i++)
+                    chunk.texcoords.push_back(ParseFloat(p, lineEnd));
+            }
+            else if(lineEnd - p >= 2 && p[0] == 'f' && IsSpace(p[1]))
+            {
+                p += 2;
+                int positionCount = chunk.positions.size() / 3;
+                int normalCount = chunk.normals.size() / 3;
+                int texcoordCount = chunk.texcoords.size() / 2;
+
+                face.clear();
+                while(true)
+                {
+                    SkipSpaces(p, lineEnd);
+                    if(p >= lineEnd)
+                        break;
+
+                    ObjCorner corner = { -1, -1, -1, 0 };
+                    bool valid = ParseIndex(p, lineEnd, positionCount, 1, corner.relative, corner.vertex);
+                    if(valid && p < lineEnd && *p == '/')
+                    {
+                        p++;
+                        if(p < lineEnd && *p != '/' && !IsSpace(*p))
+                            valid = ParseIndex(p, lineEnd, texcoordCount, 2, corner.relative, corner.texcoord);
+                        if(valid && p < lineEnd && *p == '/')
+                        {
+                            p++;
+                            if(p < lineEnd && !IsSpace(*p))
+                                valid = ParseIndex(p, lineEnd, normalCount, 4, corner.relative, corner.normal);
+                        }
+                    }
+                    if(!valid || (p < lineEnd && !IsSpace(*p)))
+                    {
+                        chunk.valid = false;
+                        return;
+                    }
+
+                    face.push_back(corner);
+                }
+
+                // fan, same as tinyobj
+                for(size_t k = 2; k < face.size(); k++)
+                {
+                    chunk.corners.push_back(face[0]);
+                    chunk.corners.push_back(face[k - 1]);
+                    chunk.corners.push_back(face[k]);
+                }
+            }
+
+            p = lineEnd + 1;
+        }
+    }
+
+    bool ParseObjParallel(const char* path, std::vector<float>& vertexData, std::vector<uint32_t>& indexData, ThreadPool& pool)
+    {
+        vertexData.clear();
+        indexData.clear();
+
+        MappedFile file;
+        if(!file.Open(path))
+            return false;
+
+        const char* data = (const char*)file.Data();
+        const char* dataEnd = data + file.Size();
+
+        // a worker waiting on tasks queued behind it can deadlock the pool, so workers parse on their own thread
+        bool runInline = pool.IsWorkerThread();
+        std::vector<std::future<void>> tasks;
+        auto run = [&](std::function<void()> task) {
+            if(runInline)
+                task();
+            else
+                tasks.push_back(pool.Submit(std::move(task)));
+        };
+
+        size_t chunkCount = runInline ? 1 : pool.GetThreadCount() * 4;
+        if(file.Size() / chunkCount < OBJ_MIN_CHUNK_SIZE)
+            chunkCount = file.Size() / OBJ_MIN_CHUNK_SIZE + 1;
+
+        std::vector<ObjChunk> chunks(chunkCount);
+        const char* begin = data;
+        for(size_t i = 0; i < chunkCount; i++)
+        {
+            const char* end = i + 1 == chunkCount ? dataEnd : data + file.Size() * (i + 1) / chunkCount;
+            if(end < begin)
+                end = begin;
+            const char* newline = (const char*)memchr(end, '\n', dataEnd - end);
+            end = newline != nullptr ? newline + 1 : dataEnd;
+
+            chunks[i].begin = begin;
+            chunks[i].end = end;
+            begin = end;
+        }
+
+        tasks.reserve(chunkCount);
+        for(ObjChunk& chunk : chunks)
+            run([&chunk]() { ParseObjChunk(chunk); });
+        for(std::future<void>& task : tasks)
+            task.wait();
+
+        for(const ObjChunk& chunk : chunks)
+        {
+            if(!chunk.valid)
+            {
+#ifdef NMGFX_PRINT_MESSAGES
+                printf("Invalid face in obj file: %s\n", path);
+#endif
+                return false;
+            }
+        }
+
+        // merge in file order, relative indices are offset by everything before their chunk
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texcoords;
+        size_t cornerCount = 0;
+        for(const ObjChunk& chunk : chunks)
+            cornerCount += chunk.corners.size();
+
+        // open addressing table of vertex indices, keys live in uniqueKeys
+        size_t capacity = 16;
+        while(capacity < cornerCount * 2)
+            capacity *= 2;
+        std::vector<uint32_t> table(capacity, INVALID_VERTEX);
+        std::vector<tinyobj::index_t> uniqueKeys;
+        uniqueKeys.reserve(cornerCount / 4);
+        indexData.reserve(cornerCount);
+
+        ObjIndexHash hasher;
+        ObjIndexEqual equal;
+        for(const ObjChunk& chunk : chunks)
+        {
+            int positionOffset = positions.size() / 3;
+            int normalOffset = normals.size() / 3;
+            int texcoordOffset = texcoords.size() / 2;
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+            texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+
+            for(const ObjCorner& corner : chunk.corners)
+            {
+                tinyobj::index_t key;
+                key.vertex_index = corner.vertex + ((corner.relative & 1) ? positionOffset : 0);
+                key.texcoord_index = corner.texcoord + ((corner.relative & 2) ? texcoordOffset : 0);
+                key.normal_index = corner.normal + ((corner.relative & 4) ? normalOffset : 0);
+
+                size_t slot = hasher(key) & (capacity - 1);
+                while(table[slot] != INVALID_VERTEX && !equal(uniqueKeys[table[slot]], key))
+                    slot = (slot + 1) & (capacity - 1);
+
+                if(table[slot] == INVALID_VERTEX)
+                {
+                    table[slot] = uniqueKeys.size();
+                    uniqueKeys.push_back(key);
+                }
+                indexData.push_back(table[slot]);
+            }
+        }
+
+        // corners may point forward into later chunks, so indices are validated only after everything is merged
+        int positionCount = positions.size() / 3;
+        int normalCount = normals.size() / 3;
+        int texcoordCount = texcoords.size() / 2;
+        for(const tinyobj::index_t& key : uniqueKeys)
+        {
+            // -1 is an omitted uv or normal
+            if(key.vertex_index < 0 || key.vertex_index >= positionCount
+            || key.texcoord_index < -1 || key.texcoord_index >= texcoordCount
+            || key.normal_index < -1 || key.normal_index >= normalCount)
+            {
+#ifdef NMGFX_PRINT_MESSAGES
+                printf("Obj file references missing vertex data: %s\n", path);
+#endif
+                indexData.clear();
+                return false;
+            }
+        }
+
+        vertexData.resize(uniqueKeys.size() * 8);
+        size_t vertexCount = uniqueKeys.size();
+        size_t taskCount = runInline ? 1 : pool.GetThreadCount();
+        tasks.clear();
+        for(size_t t = 0; t < taskCount; t++)
+        {
+            size_t first = vertexCount * t / taskCount;
+            size_t last = vertexCount * (t + 1) / taskCount;
+            run([&, first, last]() {
+                for(size_t v = first; v < last; v++)
+                {
+                    const tinyobj::index_t& key = uniqueKeys[v];
+                    float* vertex = &vertexData[v * 8];
+
+                    vertex[0] = positions[(size_t)key.vertex_index * 3 + 0];
+                    vertex[1] = positions[(size_t)key.vertex_index * 3 + 1];
+                    vertex[2] = positions[(size_t)key.vertex_index * 3 + 2];
+
+                    if(key.normal_index >= 0)
+                    {
+                        vertex[3] = normals[(size_t)key.normal_index * 3 + 0];
+                        vertex[4] = normals[(size_t)key.normal_index * 3 + 1];
+                        vertex[5] = normals[(size_t)key.normal_index * 3 + 2];
+                    }
+                    else
+                        vertex[3] = vertex[4] = vertex[5] = 0.f;
+
+                    if(key.texcoord_index >= 0)
+                    {
+                        vertex[6] = texcoords[(size_t)key.texcoord_index * 2 + 0];
+                        vertex[7] = 1.0f - texcoords[(size_t)key.texcoord_index * 2 + 1];
+                    }
+                    else
+                        vertex[6] = vertex[7] = 0.f;
+                }
+            });
+        }
+        for(std::future<void>& task : tasks)
+            task.wait();
+
+        return true;
+    }
+} // namespace nmGfx
@@ -0,0 +1,50 @@
+#ifndef __NM_GFX_OBJ_PARSER_HPP__
+#define __NM_GFX_OBJ_PARSER_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "nm_ThreadPool.hpp"
+
+namespace nmGfx
+{
+    // Corners with equal position, normal and uv indices become one vertex. Index is tinyobj::index_t,
+    // templated so this header doesn't include tiny_obj_loader.h next to its implementation
+    struct ObjIndexHash
+    {
+        template<typename Index>
+        size_t operator()(const Index& index) const
+        {
+            size_t hash = (uint32_t)index.vertex_index * 73856093u;
+            hash ^= (uint32_t)index.normal_index * 19349663u;
+            hash ^= (uint32_t)index.texcoord_index * 83492791u;
+            return hash;
+        }
+    };
+    struct ObjIndexEqual
+    {
+        template<typename Index>
+        bool operator()(const Index& a, const Index& b) const
+        {
+            return a.vertex_index == b.vertex_index && a.normal_index == b.normal_index && a.texcoord_index == b.texcoord_index;
+        }
+    };
+
+    /**
+     * @brief Parses obj file on multiple threads, output matches LoadObjMesh (tinyobj) vertex for vertex
+     *
+     * File is memory mapped and split into line aligned chunks, chunks are parsed in parallel and merged in file order.
+     * Only geometry is read (v, vt, vn, f), polygons are triangulated as fans. Materials, groups and smoothing are ignored.
+     *
+     * @param path
+     * @param vertexData vec3 pos, vec3 normal, vec2 uv
+     * @param indexData triangle list
+     * @param pool called from one of its own workers, the file is parsed on that thread instead of waiting on the pool
+     * @return false if file can't be read, has malformed face indices or references missing positions, uvs or normals
+     */
+    bool ParseObjParallel(const char* path, std::vector<float>& vertexData, std::vector<uint32_t>& indexData, ThreadPool& pool = ThreadPool::Shared());
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_OBJ_PARSER_HPP__
@@ -2,12 +2,14 @@
 
 #include <vector>
 #include <string.h>
+#include <algorithm>
 #include "Core/nm_Renderer.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/vector_angle.hpp"
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 #include "Core/nm_Matrix.hpp"
+#include "Core/GL/nm_StateCache.hpp"
 
 #include "ft2build.h"
 #include FT_FREETYPE_H
@@ -19,8 +21,12 @@ namespace nmGfx
     {
         _window = nmGfx::Window(windowWidth, windowHeight, videoWidth, videoHeight, title, flags);
 
-        _data2d._frameBuffer.Create2DDefault(&_window, videoWidth, videoHeight);
-        _data3d._gBuffer.CreateGBuffer(&_window, videoWidth, videoHeight);
+        _data2d._frameBuffer.Create2DDefault(&_window, videoWidth, videoHeight, _pickMode2D == PickMode::GPU);
+        { // gBuffer, position and normal outputs of default.glsl aren't read by any pass so they get no storage
+            FramebufferDesc desc(videoWidth, videoHeight, AttachmentFormat::RGBA16F);
+            desc.AddColor(AttachmentFormat::NONE).AddColor(AttachmentFormat::NONE).AddColor(AttachmentFormat::R32I);
+            _data3d._gBuffer.Create(desc);
+        }
         
         unsigned char pixel[3] = { 255, 255, 255 };
         _whiteTexture.LoadFromData(pixel, 1, 1, 3);
@@ -77,6 +83,42 @@ namespace nmGfx
             _data2d._model2d.UploadAttributes();
         }
 
+        { // 2d sprite batch
+            _data2d._batchVAO.Create();
+            _data2d._batchVBO.Create(BufferType::VERTEX_BUFFER);
+            _data2d._batchEBO.Create(BufferType::INDEX_BUFFER);
+
+            std::vector<uint32_t> indices(Data2D::MAX_BATCH_QUADS * 6);
+            for(uint32_t i = 0; i < Data2D::MAX_BATCH_QUADS; i++)
+            {
+                indices[i * 6 + 0] = i * 4 + 0;
+                indices[i * 6 + 1] = i * 4 + 1;
+                indices[i * 6 + 2] = i * 4 + 2;
+                indices[i * 6 + 3] = i * 4 + 0;
+                indices[i * 6 + 4] = i * 4 + 2;
+                indices[i * 6 + 5] = i * 4 + 3;
+            }
+
+            _data2d._batchVAO.Use();
+            _data2d._batchVBO.Use();
+            _data2d._batchVBO.BufferData(nullptr, Data2D::MAX_BATCH_QUADS * 4 * sizeof(Data2D::SpriteVertex), BufferUsage::DYNAMIC_DRAW);
+            _data2d._batchEBO.Use();
+            _data2d._batchEBO.BufferData(indices.data(), indices.size() * sizeof(uint32_t), BufferUsage::STATIC_DRAW);
+
+            _data2d._batchVAO.ResetAttributes();
+            _data2d._batchVAO.SetAttribute(0, AttributeType::VEC3);
+            _data2d._batchVAO.SetAttribute(1, AttributeType::VEC2);
+            _data2d._batchVAO.SetAttribute(2, AttributeType::VEC4);
+            _data2d._batchVAO.SetAttribute(3, AttributeType::INT);
+            _data2d._batchVAO.SetAttribute(4, AttributeType::INT);
+            _data2d._batchVAO.UploadAttributes();
+            VertexArray::Unbind();
+
+            _data2d._batchVertices.reserve(Data2D::MAX_BATCH_QUADS * 4);
+        }
+
+        _data3d._instanceVBO.Create(BufferType::VERTEX_BUFFER);
+
         { // skybox cube
             static const float skybox_vertices[] = {
                 /*       aPos       */  
@@ -127,21 +169,6 @@ namespace nmGfx
             return false;
         }
 
-    
-        _GlyphVAO.Create();
-        _GlyphVBO.Create(BufferType::VERTEX_BUFFER);
-
-        _GlyphVAO.Use();
-        _GlyphVBO.Use();
-
-        _GlyphVBO.BufferData(nullptr, sizeof(float) * 6 * 4, BufferUsage::DYNAMIC_DRAW);
-
-        _GlyphVAO.ResetAttributes();
-        _GlyphVAO.SetAttribute(0, AttributeType::VEC4);
-        _GlyphVAO.UploadAttributes();
-
-        _GlyphVBO.Unbind();
-        VertexArray::Unbind();
 
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -159,8 +186,26 @@ namespace nmGfx
     {
         _window.UnbindFramebuffer();
         glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glDisable(GL_DEPTH_TEST);
+        StateCache::Get().SetEnabled(GL_DEPTH_TEST, false);
         glClear(GL_COLOR_BUFFER_BIT);
+
+        // evict before uploading, so reloads of evicted textures aren't counted twice
+        _frameIndex++;
+        Texture::s_CurrentFrame = _frameIndex;
+        _textureCache.Update(_frameIndex);
+        _textureLoader.Update(_textureUploadBudget);
+        _pickReader.Update();
+        _renderTargets.Update(_frameIndex);
+    }
+
+    std::shared_ptr<Texture> Renderer::LoadTextureAsync(const std::string& path)
+    {
+        return _textureCache.Load(path);
+    }
+
+    std::shared_ptr<Texture> Renderer::LoadTextureFromMemoryAsync(std::vector<unsigned char> fileData)
+    {
+        return _textureCache.LoadFromMemory(std::move(fileData));
     }
 
     void Renderer::Begin3D(const glm::mat4 projectionMatrix, const glm::mat4 cameraTransform)
@@ -169,8 +214,9 @@ namespace nmGfx
         _data3d._viewMatrix = glm::inverse(cameraTransform);
 
         _data3d._gBuffer.Use();
+        _data3d._drawn = true;
         glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glEnable(GL_DEPTH_TEST);
+        StateCache::Get().SetEnabled(GL_DEPTH_TEST, true);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         if(_data3d._skyboxTexture != nullptr)
@@ -190,15 +236,28 @@ namespace nmGfx
         _data3d._shader.Use();
         glm::mat4 view_proj = _data3d._projectionMatrix * _data3d._viewMatrix;
         _data3d._shader.UniformMat4("uViewProjection", view_proj);
+
+        _data3d._uModel = _data3d._shader.GetUniform("uModel");
+        _data3d._uMatAlbedo = _data3d._shader.GetUniform("uMat_Albedo");
+        _data3d._uMatAlbedoTex = _data3d._shader.GetUniform("uMat_AlbedoTex");
+        _data3d._uDrawID = _data3d._shader.GetUniform("uDrawID");
+        _data3d._uInstanced = _data3d._shader.GetUniform("uInstanced");
+
+        _data3d._queue.clear();
+        _data3d._sortItems.clear();
+        _data3d._instanceData.clear();
     }
 
     void Renderer::End3D()
     {
+        Flush3DQueue();
         _window.UnbindFramebuffer();
     }
 
     int Renderer::Get3DPickID(int x, int y)
     {
+        Flush3DQueue();
+
         int id = 0;
         glReadBuffer(GL_COLOR_ATTACHMENT3);
         glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_INT, &id);
@@ -214,31 +273,204 @@ namespace nmGfx
         return id;
     }
 
+    void Renderer::Get3DPickIDAsync(int x, int y, PickCallback callback)
+    {
+        Flush3DQueue();
+
+        _pickReader.ReadAsync(GL_COLOR_ATTACHMENT3, x, y, 1, 1, [callback](const int* ids, int, int) {
+            callback(ids[0]);
+        });
+    }
+
+    void Renderer::Get3DPickIDsInRectAsync(int x, int y, int width, int height, PickRectCallback callback)
+    {
+        Flush3DQueue();
+        ReadPickIDsAsync(GL_COLOR_ATTACHMENT3, x, y, width, height, std::move(callback));
+    }
+
+    void Renderer::ReadPickIDsAsync(unsigned int attachment, int x, int y, int width, int height, PickRectCallback callback)
+    {
+        _pickReader.ReadAsync(attachment, x, y, width, height, [callback](const int* ids, int width, int height) {
+            std::vector<int> unique(ids, ids + (size_t)width * height);
+            std::sort(unique.begin(), unique.end());
+            unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+            // 0 is cleared background
+            unique.erase(std::remove(unique.begin(), unique.end(), 0), unique.end());
+            callback(unique);
+        });
+    }
+
+    /*
+     * Sort key layout, most significant bit first
+     *   opaque:      [pass 2][instanced 1][texture 16][vertex array 16][depth 24, front to back]
+     *   transparent: [pass 2][depth 24, back to front][instanced 1][texture 16][vertex array 16]
+     * Opaque draws are grouped by state and go front to back inside each group for early-z,
+     * transparent ones are strictly back to front. There is a single 3d program so no shader bits.
+     */
+    enum RenderPass3D : uint64_t
+    {
+        RenderPass3D_OPAQUE = 0,
+        RenderPass3D_TRANSPARENT = 1,
+    };
+
+    static uint32_t DepthToBits(float depth)
+    {
+        // bit pattern of a non negative float grows with its value, top 24 bits keep the order
+        if (!(depth > 0.f))
+            depth = 0.f;
+        uint32_t bits;
+        memcpy(&bits, &depth, sizeof(bits));
+        return bits >> 8;
+    }
+
+    uint64_t Renderer::Make3DSortKey(const Model& model, const glm::mat4& transform, const glm::vec4& albedo, Texture* albedoTex, bool instanced)
+    {
+        glm::vec4 viewPos = _data3d._viewMatrix * transform[3];
+        uint64_t depth = DepthToBits(-viewPos.z);
+        uint64_t texture = (albedoTex ? albedoTex->ID() : _whiteTexture.ID()) & 0xFFFF;
+        uint64_t vertexArray = model._vao2d.ID() & 0xFFFF;
+        uint64_t instancedBit = instanced ? 1 : 0;
+
+        if (albedo.a < 1.f)
+        {
+            return ((uint64_t)RenderPass3D_TRANSPARENT << 62)
+                 | ((0xFFFFFF - depth) << 38)
+                 | (instancedBit << 37)
+                 | (texture << 21)
+                 | (vertexArray << 5);
+        }
+        return ((uint64_t)RenderPass3D_OPAQUE << 62)
+             | (instancedBit << 61)
+             | (texture << 45)
+             | (vertexArray << 29)
+             | (depth << 5);
+    }
+
     void Renderer::DrawModel(const Model& model, const glm::mat4& transform, const Material& material, int drawID /*= 0*/)
     {
-        _data3d._shader.UniformMat4("uModel", transform);
-        // Material (conditions in textures are for one lining  'if texture is null, bind white texture')
-        _data3d._shader.UniformVec4("uMat_Albedo", material.albedo);
-        _data3d._shader.UniformTexture("uMat_AlbedoTex", material.albedo_tex ? *(material.albedo_tex) : _whiteTexture, 0);
-        // _data3d._shader.UniformFloat("uMat_Specular", material.specular);
-        // _data3d._shader.UniformTexture("uMat_SpecularTex", material.specular_tex ? *(material.specular_tex) : _whiteTexture, 1);
+        Texture* albedoTex = material.albedo_tex.get();
+        _data3d._sortItems.push_back(Data3D::SortItem{ Make3DSortKey(model, transform, material.albedo, albedoTex, false), (uint32_t)_data3d._queue.size() });
+        _data3d._queue.push_back(Data3D::DrawCommand{ &model, transform, material.albedo, albedoTex, drawID, 0, 0 });
+    }
 
-        _data3d._shader.UniformInt("uDrawID", drawID);
-        model.Draw();
+    void Renderer::DrawModelInstanced(Model& model, const std::vector<glm::mat4>& transforms, const Material& material, const std::vector<int>& drawIDs /*= {}*/)
+    {
+        if (transforms.empty())
+            return;
+
+        uint32_t first = _data3d._instanceData.size();
+        _data3d._instanceData.resize(first + transforms.size());
+        for (size_t i = 0; i < transforms.size(); i++)
+        {
+            _data3d._instanceData[first + i].transform = transforms[i];
+            _data3d._instanceData[first + i].drawID = i < drawIDs.size() ? drawIDs[i] : 0;
+        }
+
+        if (model._instanceBuffer != &_data3d._instanceVBO)
+        {
+            model._vao2d.Use();
+            _data3d._instanceVBO.Use();
+            model._vao2d.SetInstanceAttribute(3, AttributeType::MAT4);
+            model._vao2d.SetInstanceAttribute(7, AttributeType::INT);
+            model._vao2d.UploadInstanceAttributes();
+            model._instanceBuffer = &_data3d._instanceVBO;
+        }
+
+        Texture* albedoTex = material.albedo_tex.get();
+        _data3d._sortItems.push_back(Data3D::SortItem{ Make3DSortKey(model, transforms[0], material.albedo, albedoTex, true), (uint32_t)_data3d._queue.size() });
+        _data3d._queue.push_back(Data3D::DrawCommand{ &model, transforms[0], material.albedo, albedoTex, 0, first, (uint32_t)transforms.size() });
+    }
+
+    // LSD radix sort, 8 bits per pass. Passes where every key has the same digit are skipped
+    static void RadixSort(std::vector<Renderer::Data3D::SortItem>& items, std::vector<Renderer::Data3D::SortItem>& scratch)
+    {
+        scratch.resize(items.size());
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            uint32_t counts[256] = {};
+            for (const auto& item : items)
+                counts[(item.key >> shift) & 0xFF]++;
+            if (counts[(items[0].key >> shift) & 0xFF] == items.size())
+                continue;
+
+            uint32_t offset = 0;
+            for (int i = 0; i < 256; i++)
+            {
+                uint32_t count = counts[i];
+                counts[i] = offset;
+                offset += count;
+            }
+            for (const auto& item : items)
+                scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+            items.swap(scratch);
+        }
+    }
+
+    void Renderer::Flush3DQueue()
+    {
+        if (_data3d._queue.empty())
+            return;
+
+        RadixSort(_data3d._sortItems, _data3d._sortScratch);
+
+        _data3d._shader.Use();
+        // sampler always reads slot 0, only the bound texture changes
+        _data3d._shader.UniformInt(_data3d._uMatAlbedoTex, 0);
+
+        bool first = true;
+        int instanced = 0;
+        int drawID = 0;
+        glm::vec4 albedo{0.f};
+        for (const auto& item : _data3d._sortItems)
+        {
+            const Data3D::DrawCommand& command = _data3d._queue[item.command];
+            int commandInstanced = command.instanceCount > 0 ? 1 : 0;
+
+            if (first || commandInstanced != instanced)
+                _data3d._shader.UniformInt(_data3d._uInstanced, commandInstanced);
+            // Material (conditions in textures are for one lining  'if texture is null, bind white texture')
+            if (first || command.albedo != albedo)
+                _data3d._shader.UniformVec4(_data3d._uMatAlbedo, command.albedo);
+            (command.albedoTex ? *command.albedoTex : _whiteTexture).Use(0);
+
+            if (commandInstanced)
+            {
+                _data3d._instanceVBO.Use();
+                _data3d._instanceVBO.BufferData(&_data3d._instanceData[command.instanceFirst], command.instanceCount * sizeof(Data3D::InstanceData), BufferUsage::DYNAMIC_DRAW);
+                command.model->DrawInstanced(command.instanceCount);
+            }
+            else
+            {
+                _data3d._shader.UniformMat4(_data3d._uModel, command.transform);
+                if (first || command.drawID != drawID)
+                    _data3d._shader.UniformInt(_data3d._uDrawID, command.drawID);
+                command.model->Draw();
+            }
+
+            first = false;
+            instanced = commandInstanced;
+            drawID = command.drawID;
+            albedo = command.albedo;
+        }
+
+        _data3d._queue.clear();
+        _data3d._sortItems.clear();
+        _data3d._instanceData.clear();
     }
 
     void Renderer::Draw3DLayer()
     {
         glm::mat4 fullproj = glm::ortho(0.f, (float)_window.GetWindowWidth(), 0.f, (float)_window.GetWindowHeight(), 0.f, 10.f); // no view matrix
         _fullscreen._shader.Use();
-        _fullscreen._shader.UniformTexture("gAlbedo", _data3d._gBuffer._gAlbedo, 0);
-        // _fullscreen._shader.UniformTexture("gPosition", _data3d._gBuffer._gPosition, 1);
-        // _fullscreen._shader.UniformTexture("gNormal", _data3d._gBuffer._gNormal, 2);
+        _fullscreen._shader.UniformTexture("gAlbedo", _data3d._gBuffer.GetAlbedoID(), 0);
+        // _fullscreen._shader.UniformTexture("gPosition", _data3d._gBuffer.GetColorID(1), 1);
+        // _fullscreen._shader.UniformTexture("gNormal", _data3d._gBuffer.GetColorID(2), 2);
         
         _fullscreen._model.Draw();
     }
 
     void Renderer::BeginPass(Framebuffer& pass) {
+        Flush2DBatch();
         pass.Use();
     }
     void Renderer::EndPass() {
@@ -255,77 +487,268 @@ namespace nmGfx
         glClear(GL_DEPTH_BUFFER_BIT);
     }
     void Renderer::SetDepthTesting(bool enabled) {
-        if(enabled)
-            glEnable(GL_DEPTH_TEST);
-        else 
-            glDisable(GL_DEPTH_TEST);
+        StateCache::Get().SetEnabled(GL_DEPTH_TEST, enabled);
     }
     void Renderer::SetBlending(bool enabled) {
-        if(enabled)
-            glEnable(GL_BLEND);
-        else 
-            glDisable(GL_BLEND);
+        StateCache::Get().SetEnabled(GL_BLEND, enabled);
     }
     void Renderer::DrawQuad(Shader& shader) {
+        Flush2DBatch();
         shader.Use();
         _data2d._model2d.Draw();
     }
     void Renderer::DrawText(nmGfx::Shader &s, Font& font, const std::string& text, float scale)
     {
-        // activate corresponding render state	
-        s.Use();
-        // s.UniformVec3("textColor", color);
-        _GlyphVAO.Use();
+        DrawTextLayout(s, *GetTextLayout(font, text, scale));
+    }
+
+    static uint64_t HashTextLayoutKey(uint64_t fontId, const std::string& text, float scale)
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void* data, size_t size) {
+            const unsigned char* bytes = (const unsigned char*)data;
+            for (size_t i = 0; i < size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        mix(&fontId, sizeof(fontId));
+        mix(&scale, sizeof(scale));
+        mix(text.data(), text.size());
+        return hash;
+    }
+
+    std::shared_ptr<TextLayout> Renderer::GetTextLayout(Font& font, const std::string& text, float scale)
+    {
+        uint64_t key = HashTextLayoutKey(font._Id, text, scale);
+
+        std::list<TextLayoutEntry>::iterator entry;
+        auto it = _TextLayoutCache.find(key);
+        if (it != _TextLayoutCache.end())
+        {
+            entry = it->second;
+            _TextLayoutLRU.splice(_TextLayoutLRU.begin(), _TextLayoutLRU, entry);
+
+            TextLayout& layout = *entry->layout;
+            if (layout._fontId == font._Id && layout._scale == scale && layout._text == text)
+            {
+                if (layout._atlasGeneration != font._AtlasGeneration)
+                    BuildTextLayout(layout, font, text, scale);
+                return entry->layout;
+            }
+            // hash collision, entry is taken over by this text
+        }
+        else
+        {
+            std::shared_ptr<TextLayout> recycled;
+            if (_TextLayoutLRU.size() >= _TextLayoutCacheSize)
+            {
+                // reuse gl objects of dropped layout unless someone still holds it
+                TextLayoutEntry& last = _TextLayoutLRU.back();
+                if (last.layout.use_count() == 1)
+                    recycled = std::move(last.layout);
+                _TextLayoutCache.erase(last.key);
+                _TextLayoutLRU.pop_back();
+            }
+            _TextLayoutLRU.push_front(TextLayoutEntry{ key, recycled ? recycled : std::make_shared<TextLayout>() });
+            entry = _TextLayoutLRU.begin();
+            _TextLayoutCache[key] = entry;
+        }
+
+        if (entry->layout.use_count() > 1)
+            entry->layout = std::make_shared<TextLayout>();
+        BuildTextLayout(*entry->layout, font, text, scale);
+        return entry->layout;
+    }
+
+    void Renderer::SetTextLayoutCacheSize(size_t size)
+    {
+        _TextLayoutCacheSize = size > 0 ? size : 1;
+        while (_TextLayoutLRU.size() > _TextLayoutCacheSize)
+        {
+            _TextLayoutCache.erase(_TextLayoutLRU.back().key);
+            _TextLayoutLRU.pop_back();
+        }
+    }
 
-        // iterate through all characters
-        std::string::const_iterator c;
+    void Renderer::BuildTextLayout(TextLayout& layout, Font& font, const std::string& text, float scale)
+    {
+        // resolve glyphs first, lazily loaded ones may add atlas pages
+        font.BeginUse();
+        _GlyphQuads.clear();
+
+        glm::vec4 bounds{0.f, 0.f, 0.f, 0.f};
         float x = 0.f;
         float y = 0.f;
-        for (c = text.begin(); c != text.end(); c++)
+        std::string::const_iterator c = text.begin();
+        while (c != text.end())
         {
-            Font::Character ch = font._Characters[*c];
+            uint32_t codepoint = Font::NextCodepoint(c, text.end());
+            if (codepoint == '\n')
+            {
+                x = 0.f;
+                y -= font._LineHeight * scale;
+                continue;
+            }
 
+            const Font::Character* ch = font.GetCharacter(codepoint);
+            if (ch == nullptr)
+                continue;
 
-            float xpos = x + ch.Bearing.x * scale;
-            float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
+            if (ch->Page >= 0)
+            {
+                float xpos = x + ch->Bearing.x * scale;
+                float ypos = y - (ch->Size.y - ch->Bearing.y) * scale;
 
-            float w = ch.Size.x * scale;
-            float h = ch.Size.y * scale;
-            float vertices[6][4] = {
-                { xpos,     ypos + h,   0.0f, 0.0f },            
-                { xpos,     ypos,       0.0f, 1.0f },
-                { xpos + w, ypos,       1.0f, 1.0f },
+                float w = ch->Size.x * scale;
+                float h = ch->Size.y * scale;
+                glm::vec4 rect{ xpos, ypos, xpos + w, ypos + h };
+                _GlyphQuads.push_back(GlyphQuad{ ch->Page, rect, { ch->UVMin.x, ch->UVMin.y, ch->UVMax.x, ch->UVMax.y } });
 
-                { xpos,     ypos + h,   0.0f, 0.0f },
-                { xpos + w, ypos,       1.0f, 1.0f },
-                { xpos + w, ypos + h,   1.0f, 0.0f }           
-            };
-            // render glyph texture over quad
-            s.UniformTexture("text", ch.TextureID, 0);
-            // update content of VBO memory
-            _GlyphVBO.Use();
-            _GlyphVBO.BufferSubData(vertices, sizeof(vertices), 0);
-            // glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+                if (_GlyphQuads.size() == 1)
+                    bounds = rect;
+                bounds = glm::vec4(glm::min(glm::vec2(bounds), glm::vec2(rect)), glm::max(glm::vec2(bounds.z, bounds.w), glm::vec2(rect.z, rect.w)));
+            }
             // now advance cursors for next glyph (note that advance is number of 1/64 pixels)
-            x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64)
+            x += (ch->Advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64)
+        }
+
+        TextMetrics metrics = MeasureText(font, text, scale);
+
+        layout._font = &font;
+        layout._fontId = font._Id;
+        layout._atlasGeneration = font._AtlasGeneration;
+        if (&layout._text != &text)
+            layout._text = text;
+        layout._scale = scale;
+        layout._size = glm::vec2(metrics.width, metrics.height);
+        layout._bounds = bounds;
+        layout._lines = metrics.lines;
+
+        // build quads of every glyph, one draw per atlas page (usually one)
+        _GlyphVertices.clear();
+        layout._pages.clear();
+
+        for (size_t page = 0; page < font._Pages.size(); page++)
+        {
+            uint32_t first = _GlyphVertices.size();
+
+            for (const GlyphQuad& quad : _GlyphQuads)
+            {
+                if (quad.page != (int)page)
+                    continue;
+
+                const glm::vec4& r = quad.rect;
+                const glm::vec4& uv = quad.uv;
+                _GlyphVertices.push_back({ r.x, r.w, uv.x, uv.y });
+                _GlyphVertices.push_back({ r.x, r.y, uv.x, uv.w });
+                _GlyphVertices.push_back({ r.z, r.y, uv.z, uv.w });
+
+                _GlyphVertices.push_back({ r.x, r.w, uv.x, uv.y });
+                _GlyphVertices.push_back({ r.z, r.y, uv.z, uv.w });
+                _GlyphVertices.push_back({ r.z, r.w, uv.z, uv.y });
+            }
+
+            uint32_t count = _GlyphVertices.size() - first;
+            if (count > 0)
+                layout._pages.push_back(TextLayout::PageRange{ font._Pages[page].TextureID, first, count });
         }
-        VertexArray::Unbind();
+
+        if (_GlyphVertices.empty())
+            return;
+
+        if (!layout._uploaded)
+        {
+            layout._vao.Create();
+            layout._vbo.Create(BufferType::VERTEX_BUFFER);
+
+            layout._vao.Use();
+            layout._vbo.Use();
+            layout._vao.ResetAttributes();
+            layout._vao.SetAttribute(0, AttributeType::VEC4);
+            layout._vao.UploadAttributes();
+            layout._uploaded = true;
+        }
+
+        layout._vao.Use();
+        layout._vbo.Use();
+        layout._vbo.BufferData(_GlyphVertices.data(), _GlyphVertices.size() * sizeof(glm::vec4), BufferUsage::STATIC_DRAW);
     }
 
-    glm::vec2 Renderer::CalcTextSize(Font& font, const std::string& text, float scale) {
-        glm::vec2 size{0.f, 0.f};
+    void Renderer::DrawTextLayout(Shader& s, TextLayout& layout)
+    {
+        Flush2DBatch();
+
+        if (layout._font != nullptr && layout._atlasGeneration != layout._font->_AtlasGeneration)
+            BuildTextLayout(layout, *layout._font, layout._text, layout._scale);
+        if (layout._pages.empty())
+            return;
+
+        // activate corresponding render state	
+        s.Use();
+        // s.UniformVec3("textColor", color);
+        UniformHandle textHandle = s.GetUniform("text");
 
-        std::string::const_iterator c;
-        for (c = text.begin(); c != text.end(); c++)
+        layout._vao.Use();
+        for (const TextLayout::PageRange& page : layout._pages)
         {
-            Font::Character ch = font._Characters[*c];
-            size.x += (ch.Advance >> 6) * scale;
-            if(ch.Size.y > size.y)
-                size.y = ch.Size.y;
+            // render glyph texture over quads
+            s.UniformTexture(textHandle, page.textureID, 0);
+            glDrawArrays(GL_TRIANGLES, page.first, page.count);
         }
-        
-        return size;
+    }
+
+    Renderer::TextMetrics Renderer::MeasureText(Font& font, const std::string& text, float scale) {
+        TextMetrics metrics;
+        if (text.empty())
+            return metrics;
+
+        float lineWidth = 0.f;
+        int lineHeight = 0; // tallest glyph of current line
+        metrics.lines = 1;
+
+        std::string::const_iterator c = text.begin();
+        while (c != text.end())
+        {
+            uint32_t codepoint = Font::NextCodepoint(c, text.end());
+            if (codepoint == '\n')
+            {
+                if (lineWidth > metrics.width)
+                    metrics.width = lineWidth;
+                metrics.height += font._LineHeight * scale;
+                metrics.lines++;
+                lineWidth = 0.f;
+                lineHeight = 0;
+                continue;
+            }
+
+            const Font::Character* ch = font.GetCharacter(codepoint);
+            if (ch == nullptr)
+                continue;
+            lineWidth += (ch->Advance >> 6) * scale;
+            if (ch->Size.y > lineHeight)
+                lineHeight = ch->Size.y;
+        }
+
+        if (lineWidth > metrics.width)
+            metrics.width = lineWidth;
+        metrics.height += lineHeight * scale;
+        return metrics;
+    }
+
+    glm::vec2 Renderer::CalcTextSize(Font& font, const std::string& text, float scale) {
+        font.BeginUse();
+        TextMetrics metrics = MeasureText(font, text, scale);
+        return glm::vec2(metrics.width, metrics.height);
+    }
+
+    void Renderer::CalcTextSize(Font& font, const std::vector<std::string>& texts, std::vector<TextMetrics>& metrics, float scale) {
+        font.BeginUse();
+        metrics.resize(texts.size());
+        for (size_t i = 0; i < texts.size(); i++)
+            metrics[i] = MeasureText(font, texts[i], scale);
     }
 
     void Renderer::DrawPassLayer(Framebuffer& pass) {
@@ -339,6 +762,7 @@ namespace nmGfx
 
 	void Renderer::Begin2D(const glm::mat4 cameraTransform, const glm::vec2 &cameraCenter /*= {0.5f, 0.5f}*/, const glm::vec4& clearColor /*= {0.f, 0.f, 0.f, 0.f}*/) {
 		_data2d._frameBuffer.Use();
+		_data2d._drawn = true;
         SetClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
 		SetDepthTesting(true);
         ClearColor();
@@ -352,14 +776,49 @@ namespace nmGfx
 		_data2d._viewMatrix = glm::inverse(cameraTransform);
 
 		glm::mat4 view_proj = _data2d._projectionMatrix * _data2d._viewMatrix;
+		_data2d._viewProjectionMatrix = view_proj;
 		_data2d._shader.UniformMat4("uViewProjection", view_proj);
+
+		if (_pickMode2D == PickMode::CPU)
+			_spritePicker.Begin(_data2d._frameBuffer._width, _data2d._frameBuffer._height);
+
+		int slots[Data2D::MAX_BATCH_TEXTURES];
+		for (uint32_t i = 0; i < Data2D::MAX_BATCH_TEXTURES; i++)
+			slots[i] = i;
+		_data2d._uTextures = _data2d._shader.GetUniform("uTextures");
+		_data2d._shader.UniformIntArray(_data2d._uTextures, slots, Data2D::MAX_BATCH_TEXTURES);
+
+		_data2d._batchVertices.clear();
+		_data2d._batchTextureCount = 0;
 	}
 
 	void Renderer::End2D() {
+		Flush2DBatch();
 		_window.UnbindFramebuffer();
 	}
 
+	void Renderer::Set2DPickMode(PickMode mode) {
+		if (mode == _pickMode2D)
+			return;
+		_pickMode2D = mode;
+
+		// before Init framebuffer is created with the right attachments later
+		Framebuffer& framebuffer = _data2d._frameBuffer;
+		if (framebuffer._id != 0) {
+			int width = framebuffer._width;
+			int height = framebuffer._height;
+			framebuffer.Destroy();
+			framebuffer.Create2DDefault(&_window, width, height, mode == PickMode::GPU);
+		}
+		_spritePicker.Begin(framebuffer._width, framebuffer._height);
+	}
+
 	int Renderer::Get2DPickID(int x, int y) {
+		if (_pickMode2D == PickMode::CPU)
+			return _spritePicker.Pick(x, y);
+
+		Flush2DBatch();
+
 		int id = 0;
 		glReadBuffer(GL_COLOR_ATTACHMENT1);
 		glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_INT, &id);
@@ -367,6 +826,9 @@ namespace nmGfx
 	}
 
 	int Renderer::Get2DPickIDSafe(int x, int y) {
+		if (_pickMode2D == PickMode::CPU)
+			return _spritePicker.Pick(x, y);
+
 		_data2d._frameBuffer.Use();
 		int id = Get2DPickID(x, y);
 		_window.UnbindFramebuffer();
@@ -374,80 +836,294 @@ namespace nmGfx
 		return id;
 	}
 
+	void Renderer::Get2DPickIDAsync(int x, int y, PickCallback callback) {
+		if (_pickMode2D == PickMode::CPU) {
+			callback(_spritePicker.Pick(x, y));
+			return;
+		}
+
+		Flush2DBatch();
+
+		_pickReader.ReadAsync(GL_COLOR_ATTACHMENT1, x, y, 1, 1, [callback](const int *ids, int, int) {
+			callback(ids[0]);
+		});
+	}
+
+	void Renderer::Get2DPickIDsInRectAsync(int x, int y, int width, int height, PickRectCallback callback) {
+		if (_pickMode2D == PickMode::CPU) {
+			std::vector<int> ids;
+			_spritePicker.PickRect(x, y, width, height, ids);
+			callback(ids);
+			return;
+		}
+
+		Flush2DBatch();
+		ReadPickIDsAsync(GL_COLOR_ATTACHMENT1, x, y, width, height, std::move(callback));
+	}
+
 	void Renderer::DrawTexture(Texture *texture, const glm::mat4 &transform, const glm::vec4 &tint /*= glm::vec4(1.f)*/, int drawID /*= 0*/) {
-		_data2d._shader.UniformMat4("uModel", transform);
-		_data2d._shader.UniformVec4("uTint", tint);
-		_data2d._shader.UniformTexture("uTexture", texture ? *(texture) : _whiteTexture, 1);
+		unsigned int textureID = texture ? texture->ID() : _whiteTexture.ID();
+		// batch binds by id, so residency is marked here instead of by Texture::Use
+		if (texture)
+			texture->_lastUsedFrame = _frameIndex;
+
+		Push2DQuad(textureID, transform, tint, drawID);
+
+		// fully transparent tints are discarded by the shader, so they aren't pickable either
+		if (_pickMode2D == PickMode::CPU && tint.a >= 0.1f) {
+			const Data2D::SpriteVertex* quad = &_data2d._batchVertices[_data2d._batchVertices.size() - 4];
+			glm::vec2 size((float)_data2d._frameBuffer._width, (float)_data2d._frameBuffer._height);
+			glm::vec3 pixels[4];
+			for (int i = 0; i < 4; i++) {
+				glm::vec4 clip = _data2d._viewProjectionMatrix * glm::vec4(quad[i].position, 1.f);
+				glm::vec3 ndc = glm::vec3(clip) / clip.w;
+				pixels[i] = glm::vec3((glm::vec2(ndc) * 0.5f + 0.5f) * size, ndc.z);
+			}
+			_spritePicker.Insert(pixels, drawID);
+		}
+	}
+
+	void Renderer::Push2DQuad(unsigned int textureID, const glm::mat4 &transform, const glm::vec4 &tint, int drawID) {
+		int textureIndex = -1;
+		for (uint32_t i = 0; i < _data2d._batchTextureCount; i++) {
+			if (_data2d._batchTextures[i] == textureID) {
+				textureIndex = i;
+				break;
+			}
+		}
+
+		if (textureIndex < 0) {
+			if (_data2d._batchTextureCount == Data2D::MAX_BATCH_TEXTURES)
+				Flush2DBatch();
+			textureIndex = _data2d._batchTextureCount;
+			_data2d._batchTextures[_data2d._batchTextureCount++] = textureID;
+		}
+		if (_data2d._batchVertices.size() == Data2D::MAX_BATCH_QUADS * 4) {
+			Flush2DBatch();
+			textureIndex = 0;
+			_data2d._batchTextures[_data2d._batchTextureCount++] = textureID;
+		}
+
+		static const glm::vec4 corners[4] = {
+			{-0.5f,  0.5f, 0.f, 1.f},
+			{-0.5f, -0.5f, 0.f, 1.f},
+			{ 0.5f, -0.5f, 0.f, 1.f},
+			{ 0.5f,  0.5f, 0.f, 1.f},
+		};
+		static const glm::vec2 uvs[4] = {
+			{0.f, 1.f},
+			{0.f, 0.f},
+			{1.f, 0.f},
+			{1.f, 1.f},
+		};
+		for (int i = 0; i < 4; i++) {
+			_data2d._batchVertices.push_back(Data2D::SpriteVertex{
+				glm::vec3(transform * corners[i]),
+				uvs[i],
+				tint,
+				textureIndex,
+				drawID});
+		}
+	}
+
+	void Renderer::UpdateLayer2D(Layer2D &layer) {
+		Flush2DBatch();
+
+		// loads and evictions change texture ids while the layer is static, sprites drawn with an old id are redrawn.
+		// textures of retained sprites are on screen, so they are marked as used like drawn ones
+		for (Layer2D::Sprite &sprite : layer._sprites) {
+			if (sprite.sequence == 0)
+				continue;
+			if (sprite.texture)
+				sprite.texture->_lastUsedFrame = _frameIndex;
+			unsigned int textureID = sprite.texture ? sprite.texture->ID() : _whiteTexture.ID();
+			if (textureID != sprite.drawnTextureID)
+				layer.MarkDirty(sprite.min, sprite.max);
+		}
+
+		layer._stats = Layer2D::Stats{};
+		if (!layer.IsDirty())
+			return;
+
+		layer._framebuffer.Use();
+		SetDepthTesting(true);
+		StateCache::Get().SetEnabled(GL_SCISSOR_TEST, true);
+		glClearColor(layer._clearColor.x, layer._clearColor.y, layer._clearColor.z, layer._clearColor.w);
+
+		_data2d._shader.Use();
+		_data2d._shader.UniformMat4("uViewProjection", layer._viewProjection);
+		int slots[Data2D::MAX_BATCH_TEXTURES];
+		for (uint32_t i = 0; i < Data2D::MAX_BATCH_TEXTURES; i++)
+			slots[i] = i;
+		_data2d._shader.UniformIntArray(_data2d._shader.GetUniform("uTextures"), slots, Data2D::MAX_BATCH_TEXTURES);
+
+		std::vector<Layer2D::Sprite*> sprites;
+		for (const Layer2D::Rect &rect : layer._dirtyRects) {
+			glScissor(rect.x, rect.y, rect.z - rect.x, rect.w - rect.y);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			sprites.clear();
+			for (Layer2D::Sprite &sprite : layer._sprites) {
+				if (sprite.sequence != 0 && sprite.max.x >= rect.x && sprite.min.x <= rect.z && sprite.max.y >= rect.y && sprite.min.y <= rect.w)
+					sprites.push_back(&sprite);
+			}
+			// slots are reused, sequence keeps the order sprites were added in
+			std::sort(sprites.begin(), sprites.end(), [](const Layer2D::Sprite *a, const Layer2D::Sprite *b) {
+				return a->sequence < b->sequence;
+			});
+
+			for (Layer2D::Sprite *sprite : sprites) {
+				sprite->drawnTextureID = sprite->texture ? sprite->texture->ID() : _whiteTexture.ID();
+				Push2DQuad(sprite->drawnTextureID, sprite->transform, sprite->tint, sprite->drawID);
+			}
+			Flush2DBatch();
+
+			layer._stats.rects++;
+			layer._stats.sprites += (uint32_t)sprites.size();
+			layer._stats.pixels += (uint64_t)(rect.z - rect.x) * (rect.w - rect.y);
+		}
+		layer._dirtyRects.clear();
+
+		StateCache::Get().SetEnabled(GL_SCISSOR_TEST, false);
+		_window.UnbindFramebuffer();
+	}
 
-		_data2d._shader.UniformInt("uDrawID", drawID);
-		_data2d._model2d.Draw();
+	void Renderer::Flush2DBatch() {
+		if (_data2d._batchVertices.empty()) {
+			_data2d._batchTextureCount = 0;
+			return;
+		}
+
+		_data2d._shader.Use();
+		for (uint32_t i = 0; i < _data2d._batchTextureCount; i++)
+			StateCache::Get().BindTexture(GL_TEXTURE_2D, _data2d._batchTextures[i], i);
+
+		_data2d._batchVAO.Use();
+		_data2d._batchVBO.Use();
+		// orphan previous storage so in-flight draws don't stall the upload
+		_data2d._batchVBO.BufferData(nullptr, Data2D::MAX_BATCH_QUADS * 4 * sizeof(Data2D::SpriteVertex), BufferUsage::DYNAMIC_DRAW);
+		_data2d._batchVBO.BufferSubData(_data2d._batchVertices.data(), _data2d._batchVertices.size() * sizeof(Data2D::SpriteVertex), 0);
+
+		uint32_t quadCount = _data2d._batchVertices.size() / 4;
+		glDrawElements(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_INT, nullptr);
+
+		_data2d._batchVertices.clear();
+		_data2d._batchTextureCount = 0;
 	}
 
 	void Renderer::Draw2DLayer() {
 		glm::mat4 fullproj = glm::ortho(0.f, (float)_window.GetWindowWidth(), 0.f, (float)_window.GetWindowHeight(), 0.f, 10.f); // no view matrix
 		_fullscreen._shader.Use();
-		_fullscreen._shader.UniformTexture("gAlbedo", _data2d._frameBuffer._gAlbedo, 0);
+		_fullscreen._shader.UniformTexture("gAlbedo", _data2d._frameBuffer.GetAlbedoID(), 0);
 
 		_fullscreen._model.Draw();
 	}
 
+	void Renderer::Add3DLayer(int order /*= 0*/, float opacity /*= 1.f*/, LayerBlendMode mode /*= LayerBlendMode::NORMAL*/) {
+		if (_data3d._drawn)
+			AddLayer(_data3d._gBuffer.GetAlbedoID(), order, opacity, mode);
+	}
 
-    bool Renderer::LoadFontWithFace(Font* font, FT_Face& face) {
+	void Renderer::Add2DLayer(int order /*= 1*/, float opacity /*= 1.f*/, LayerBlendMode mode /*= LayerBlendMode::NORMAL*/) {
+		if (_data2d._drawn)
+			AddLayer(_data2d._frameBuffer.GetAlbedoID(), order, opacity, mode);
+	}
+
+	void Renderer::AddPassLayer(Framebuffer& pass, int order /*= 2*/, float opacity /*= 1.f*/, LayerBlendMode mode /*= LayerBlendMode::NORMAL*/) {
+		AddLayer(pass.GetAlbedoID(), order, opacity, mode);
+	}
+
+	void Renderer::AddLayer(unsigned int textureID, int order, float opacity /*= 1.f*/, LayerBlendMode mode /*= LayerBlendMode::NORMAL*/) {
+		// fully transparent layers don't change the result
+		if (textureID != 0 && opacity > 0.f)
+			_fullscreen._layers.push_back({ textureID, order, opacity, mode });
+	}
+
+	void Renderer::CompositeLayers() {
+		std::vector<DataFullscreen::CompositeLayer>& layers = _fullscreen._layers;
+		std::stable_sort(layers.begin(), layers.end(), [](const DataFullscreen::CompositeLayer& a, const DataFullscreen::CompositeLayer& b) {
+			return a.order < b.order;
+		});
+
+		uint32_t count = (uint32_t)std::min<size_t>(layers.size(), DataFullscreen::MAX_COMPOSITE_LAYERS);
+#ifdef NMGFX_PRINT_MESSAGES
+		if (layers.size() > count)
+			printf("Compositing %u of %u layers\n", count, (uint32_t)layers.size());
+#endif
+
+		// nothing drawn, window was already cleared by ClearLayers
+		if (count > 0) {
+			int slots[DataFullscreen::MAX_COMPOSITE_LAYERS];
+			float opacities[DataFullscreen::MAX_COMPOSITE_LAYERS];
+			int modes[DataFullscreen::MAX_COMPOSITE_LAYERS];
+			StateCache& stateCache = StateCache::Get();
+			for (uint32_t i = 0; i < DataFullscreen::MAX_COMPOSITE_LAYERS; i++) {
+				slots[i] = i;
+				if (i < count) {
+					opacities[i] = layers[i].opacity;
+					modes[i] = (int)layers[i].mode;
+					stateCache.BindTexture(GL_TEXTURE_2D, layers[i].texture, i);
+				}
+			}
+
+			// shader does the blending, its output replaces what is below
+			bool blending = stateCache.IsEnabled(GL_BLEND);
+			stateCache.SetEnabled(GL_BLEND, false);
+			stateCache.SetEnabled(GL_DEPTH_TEST, false);
+
+			Shader& shader = _fullscreen._compositeShader;
+			shader.Use();
+			shader.UniformIntArray("uLayers", slots, DataFullscreen::MAX_COMPOSITE_LAYERS);
+			shader.UniformFloatArray("uOpacity", opacities, count);
+			shader.UniformIntArray("uBlendMode", modes, count);
+			shader.UniformInt("uLayerCount", count);
+			_fullscreen._model.Draw();
+
+			stateCache.SetEnabled(GL_BLEND, blending);
+		}
+
+		layers.clear();
+		_data3d._drawn = false;
+		_data2d._drawn = false;
+	}
+
+
+    bool Renderer::LoadFontWithFace(Font* font, FT_Face& face, FontRenderMode mode) {
         if (FT_Load_Char(face, 'X', FT_LOAD_RENDER))
         {
+            FT_Done_Face(face);
             return false;
         }
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // disable byte-alignment restriction
-  
-        for (int c = 0; c < 128; c++)
-        {
-            if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-                continue;
+        // face is kept alive for rasterizing the rest of the glyphs on first use
+        font->Clear();
+        font->_Face = face;
+        font->_LineHeight = (float)(face->size->metrics.height >> 6);
+        font->_RenderMode = mode;
 
-            unsigned int texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer
-            );
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            Font::Character character = {
-                texture, 
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                static_cast<unsigned int>(face->glyph->advance.x)
-            };
-            font->_Characters[c] = character;
-        }
+        for (uint32_t c = 0; c < 128; c++)
+            font->LoadGlyph(c);
 
-        FT_Done_Face(face);
         return true;
     }
-    bool Renderer::LoadFont(Font* font, const unsigned char* data, unsigned size) {
+    bool Renderer::LoadFont(Font* font, const unsigned char* data, unsigned size, FontRenderMode mode) {
         FT_Face face;
 
-        if (FT_New_Memory_Face(*_Freetype.get(), data, size, 0, &face))
+        // freetype reads from the buffer for as long as the face lives
+        std::vector<unsigned char> faceData(data, data + size);
+        if (FT_New_Memory_Face(*_Freetype.get(), faceData.data(), size, 0, &face))
         {  
             return false;
         }
         FT_Set_Pixel_Sizes(face, 0, 48);  
 
-        return LoadFontWithFace(font, face);
+        if (!LoadFontWithFace(font, face, mode))
+            return false;
+        font->_FaceData = std::move(faceData);
+        return true;
     }
 
-    bool Renderer::LoadFont(Font* font, const std::string& path) {
+    bool Renderer::LoadFont(Font* font, const std::string& path, FontRenderMode mode) {
         FT_Face face;
 
         if (FT_New_Face(*_Freetype.get(), path.c_str(), 0, &face))
@@ -456,6 +1132,6 @@ namespace nmGfx
         }
         FT_Set_Pixel_Sizes(face, 0, 48);  
 
-        return LoadFontWithFace(font, face);
+        return LoadFontWithFace(font, face, mode);
     }
 } // namespace nmGfx
@@ -3,6 +3,9 @@
 #pragma once
 
 #include <memory>
+#include <list>
+#include <unordered_map>
+#include <functional>
 
 #include <glm/glm.hpp>
 
@@ -13,16 +16,37 @@
 #include "Core/GL/nm_Framebuffer.hpp"
 #include "Core/GL/nm_Material.hpp"
 #include "Core/GL/nm_Font.hpp"
+#include "Core/GL/nm_TextLayout.hpp"
+#include "Core/GL/nm_TextureLoader.hpp"
+#include "Core/GL/nm_TextureCache.hpp"
+#include "Core/GL/nm_PickReader.hpp"
+#include "Core/GL/nm_RenderTargetPool.hpp"
+#include "Core/GL/nm_RenderGraph.hpp"
+#include "Core/GL/nm_Layer2D.hpp"
+#include "Core/nm_SpritePicker.hpp"
 
 class FT_LibraryRec_;
 class FT_FaceRec_;
 
 namespace nmGfx
 {
+    // How CompositeLayers combines a layer with the layers below it
+    enum class LayerBlendMode
+    {
+        NORMAL = 0,
+        ADDITIVE,
+        MULTIPLY,
+        SCREEN,
+    };
+
     // pure virtual base class that has renderer methods
     class Renderer
     {
     public:
+        using PickCallback = std::function<void(int id)>;
+        // unique non zero ids, sorted
+        using PickRectCallback = std::function<void(const std::vector<int>& ids)>;
+
         bool Init(int windowWidth, int windowHeight, int videoWidth, int videoHeight, const char* title, unsigned int flags);
         
         Window& GetWindow() { return _window; }
@@ -31,11 +55,45 @@ namespace nmGfx
         ~Renderer();
 
         /**
-         * @brief Call before drawing 2d/3d layers
+         * @brief Call before drawing 2d/3d layers. Also uploads async loaded textures up to upload budget
          * 
          */
         void ClearLayers();
 
+        /**
+         * @brief Loads texture on worker threads, it draws as white until upload finishes on a later ClearLayers
+         * 
+         * Textures go through texture cache, loading same path or same file contents again returns the same texture.
+         */
+        std::shared_ptr<Texture> LoadTextureAsync(const std::string& path);
+        std::shared_ptr<Texture> LoadTextureFromMemoryAsync(std::vector<unsigned char> fileData);
+        /**
+         * @brief Sets gpu memory budget of cached textures, textures not drawn in last frame are evicted over it. 0 -> unlimited
+         * 
+         */
+        inline void SetTextureMemoryBudget(uint64_t bytes) { _textureCache.SetBudget(bytes); }
+        inline TextureCache& GetTextureCache() { return _textureCache; }
+        /**
+         * @brief Sets how many pixel bytes of async loaded textures are uploaded per frame
+         * 
+         */
+        inline void SetTextureUploadBudget(uint64_t bytes) { _textureUploadBudget = bytes; }
+        inline TextureLoader& GetTextureLoader() { return _textureLoader; }
+        /**
+         * @brief Transient framebuffers for user passes, released targets unused for a few frames are destroyed on ClearLayers
+         * 
+         */
+        inline RenderTargetPool& GetRenderTargetPool() { return _renderTargets; }
+        /**
+         * @brief Graph of user passes, transient targets come from the render target pool
+         * 
+         * Layers can be imported with Get3DFramebuffer and Get2DFramebuffer. Begin3D and Begin2D clear
+         * them by themselves, so import them with LoadOp::DONT_CARE.
+         */
+        inline RenderGraph& GetRenderGraph() { return _renderGraph; }
+        inline Framebuffer& Get3DFramebuffer() { return _data3d._gBuffer; }
+        inline Framebuffer& Get2DFramebuffer() { return _data2d._frameBuffer; }
+
 
         void BeginPass(Framebuffer& pass);
         void EndPass();
@@ -45,12 +103,36 @@ namespace nmGfx
         void SetDepthTesting(bool enabled);
         void SetBlending(bool enabled);
         void DrawQuad(Shader& shader);
+        /**
+         * @brief Draws text through the layout cache, unchanged strings don't pay layout or upload cost
+         * 
+         */
         void DrawText(Shader& shader, Font& font, const std::string& text, float scale = 1.0f);
+
+        /**
+         * @brief Returns cached layout of text, building it on miss. Cache is bounded, least recently used layouts are dropped
+         * 
+         */
+        std::shared_ptr<TextLayout> GetTextLayout(Font& font, const std::string& text, float scale = 1.0f);
+        void DrawTextLayout(Shader& shader, TextLayout& layout);
+        void SetTextLayoutCacheSize(size_t size);
         glm::vec2 CalcTextSize(Font& font, const std::string& text, float scale = 1.0f);
+
+        struct TextMetrics
+        {
+            float width = 0.f;  // widest line
+            float height = 0.f; // line height of every line but the last one + tallest glyph of the last one
+            int lines = 0;
+        };
+        /**
+         * @brief Measures many strings at once. metrics is resized to texts.size(), reuse it between calls to avoid allocating
+         * 
+         */
+        void CalcTextSize(Font& font, const std::vector<std::string>& texts, std::vector<TextMetrics>& metrics, float scale = 1.0f);
         void DrawPassLayer(Framebuffer& pass);
 
         /**
-         * @brief Begin 3D context, use shaders, calculate matrices
+         * @brief Begin 3D context, use shaders, calculate matrices. Draws are queued and submitted sorted on End3D
          * 
          * @param projectionMatrix
          * @param cameraTransform Camera transform (NOT view matrix)
@@ -76,6 +158,18 @@ namespace nmGfx
          */
         int Get3DPickIDSafe(int x, int y);
 
+        /**
+         * @brief Queues read of id at x, y in 3d space without waiting for gpu. !Must be called within 3d context
+         * 
+         * Callback is called from a later ClearLayers once gpu has finished, usually one or two frames later.
+         */
+        void Get3DPickIDAsync(int x, int y, PickCallback callback);
+        /**
+         * @brief Queues read of every id in rectangle in 3d space, for marquee selection. !Must be called within 3d context
+         * 
+         */
+        void Get3DPickIDsInRectAsync(int x, int y, int width, int height, PickRectCallback callback);
+
 
         /**
          * @brief Draws 3d layer on full screen
@@ -84,8 +178,19 @@ namespace nmGfx
         void Draw3DLayer();
 
 
+        /**
+         * @brief Queues model for End3D. Model and material textures must stay alive until then
+         * 
+         */
         void DrawModel(const Model& model, const glm::mat4& transform, const Material& material, int drawID = 0);
 
+        /**
+         * @brief Draws every transform of model with one call. Transforms and draw ids are uploaded into an instance buffer
+         * 
+         * @param drawIDs per instance ids for picking, empty -> 0 for all, otherwise must be same size as transforms
+         */
+        void DrawModelInstanced(Model& model, const std::vector<glm::mat4>& transforms, const Material& material, const std::vector<int>& drawIDs = {});
+
 
         /**
          * @brief Begin 2D context, use shaders, calculate matrices (camera is on center)
@@ -96,6 +201,15 @@ namespace nmGfx
 		void Begin2D(const glm::mat4 cameraTransform, const glm::vec2 &cameraCenter = {0.5f, 0.5f}, const glm::vec4& clearColor = {0.f, 0.f, 0.f, 0.f});
 		void End2D();
 
+		/**
+		 * @brief Sets where 2d pick ids come from. In CPU mode the 2d layer has no draw id attachment,
+		 * sprites from DrawTexture are picked by shape and every 2d pick call can be made anywhere until next Begin2D
+		 * 
+		 */
+		void Set2DPickMode(PickMode mode);
+		inline PickMode Get2DPickMode() const { return _pickMode2D; }
+		inline const SpritePicker& GetSpritePicker() const { return _spritePicker; }
+
 		/**
 		 * @brief Returns id of given x, y coordinate in 2d space !Must be called within 2d context(Between Begin2D-End2D block)
 		 *
@@ -114,14 +228,64 @@ namespace nmGfx
          */
         int Get2DPickIDSafe(int x, int y);
 
+        /**
+         * @brief Queues read of id at x, y in 2d space without waiting for gpu. !Must be called within 2d context
+         * 
+         * Callback is called from a later ClearLayers once gpu has finished, usually one or two frames later.
+         */
+        void Get2DPickIDAsync(int x, int y, PickCallback callback);
+        /**
+         * @brief Queues read of every id in rectangle in 2d space, for marquee selection. !Must be called within 2d context
+         * 
+         */
+        void Get2DPickIDsInRectAsync(int x, int y, int width, int height, PickRectCallback callback);
+
+        /**
+         * @brief Queues a sprite into the 2d batch. Batch is flushed on End2D, when it is full or when another draw needs the framebuffer
+         * 
+         */
         void DrawTexture(Texture* texture, const glm::mat4& transform, const glm::vec4& tint = glm::vec4(1.f), int drawID = 0);
 
+        /**
+         * @brief Redraws dirty rectangles of retained layer into its framebuffer. !Must not be called within 2d context
+         * 
+         * Does nothing when no sprite of the layer changed. Sprites whose texture finished loading
+         * or was evicted since they were drawn are redrawn too.
+         */
+        void UpdateLayer2D(Layer2D& layer);
+
         /**
          * @brief Draws 2d layer on full screen
          * 
          */
         void Draw2DLayer();
 
+        /**
+         * @brief Queues 3d layer for CompositeLayers. Skipped if nothing was drawn in 3d since last composite
+         * 
+         * @param order layers with lower order are below
+         * @param opacity multiplies alpha of layer
+         * @param mode 
+         */
+        void Add3DLayer(int order = 0, float opacity = 1.f, LayerBlendMode mode = LayerBlendMode::NORMAL);
+        /**
+         * @brief Queues 2d layer for CompositeLayers. Skipped if nothing was drawn in 2d since last composite
+         * 
+         */
+        void Add2DLayer(int order = 1, float opacity = 1.f, LayerBlendMode mode = LayerBlendMode::NORMAL);
+        // Queues color attachment 0 of pass for CompositeLayers, pass must not be multisampled
+        void AddPassLayer(Framebuffer& pass, int order = 2, float opacity = 1.f, LayerBlendMode mode = LayerBlendMode::NORMAL);
+        // Queues any 2d texture for CompositeLayers
+        void AddLayer(unsigned int textureID, int order, float opacity = 1.f, LayerBlendMode mode = LayerBlendMode::NORMAL);
+        /**
+         * @brief Blends queued layers into current framebuffer in a single full screen pass, replacing Draw*Layer calls
+         * 
+         * Layers are blended from lowest order up, equal orders in the order they were added. Up to
+         * DataFullscreen::MAX_COMPOSITE_LAYERS layers, the topmost ones above it are dropped.
+         * Needs GetDataFullscreen()._compositeShader loaded with res/composite.glsl.
+         */
+        void CompositeLayers();
+
 
         struct Data3D
         {
@@ -131,10 +295,47 @@ namespace nmGfx
             glm::mat4 _viewMatrix;
 
             Shader _shader;
+            // resolved on Begin3D, used per draw
+            UniformHandle _uModel;
+            UniformHandle _uMatAlbedo;
+            UniformHandle _uMatAlbedoTex;
+            UniformHandle _uDrawID;
+            UniformHandle _uInstanced;
+
+            // per instance data, layout must match instance attributes of default.glsl
+            struct InstanceData
+            {
+                glm::mat4 transform;
+                int drawID;
+            };
+            Buffer _instanceVBO;
+            std::vector<InstanceData> _instanceData; // every instanced draw of the frame
+
+            // Render queue, sorted by key on End3D
+            struct DrawCommand
+            {
+                const Model* model;
+                glm::mat4 transform;
+                glm::vec4 albedo;
+                Texture* albedoTex;
+                int drawID;
+                uint32_t instanceFirst;
+                uint32_t instanceCount; // 0 -> not instanced
+            };
+            struct SortItem
+            {
+                uint64_t key;
+                uint32_t command;
+            };
+            std::vector<DrawCommand> _queue;
+            std::vector<SortItem> _sortItems;
+            std::vector<SortItem> _sortScratch;
 
             Model _skyboxModel;
             Shader _skyboxShader;
             Texture* _skyboxTexture{nullptr};
+
+            bool _drawn = false; // Begin3D was called since last CompositeLayers
         };
         struct Data2D
         {
@@ -143,35 +344,110 @@ namespace nmGfx
 
             glm::mat4 _projectionMatrix;
             glm::mat4 _viewMatrix;
+            glm::mat4 _viewProjectionMatrix;
 
             Shader _shader;
+            // resolved on Begin2D
+            UniformHandle _uTextures;
+
+            // Sprite batch, quads are transformed on cpu and drawn with one call per MAX_BATCH_TEXTURES textures
+            struct SpriteVertex
+            {
+                glm::vec3 position;
+                glm::vec2 uv;
+                glm::vec4 tint;
+                int textureIndex;
+                int drawID;
+            };
+            static const uint32_t MAX_BATCH_QUADS = 10000;
+            static const uint32_t MAX_BATCH_TEXTURES = 16; // must match uTextures size in default2d.glsl
+
+            VertexArray _batchVAO;
+            Buffer _batchVBO;
+            Buffer _batchEBO;
+            std::vector<SpriteVertex> _batchVertices;
+            unsigned int _batchTextures[MAX_BATCH_TEXTURES];
+            uint32_t _batchTextureCount = 0;
+
+            bool _drawn = false; // Begin2D was called since last CompositeLayers
         };
         struct DataFullscreen
         {
             Model _model;
             Shader _shader;
+
+            static const uint32_t MAX_COMPOSITE_LAYERS = 8; // must match uLayers size in composite.glsl
+            struct CompositeLayer
+            {
+                unsigned int texture;
+                int order;
+                float opacity;
+                LayerBlendMode mode;
+            };
+            Shader _compositeShader;
+            std::vector<CompositeLayer> _layers; // queued for CompositeLayers
         };
 
         DataFullscreen& GetDataFullscreen() { return _fullscreen; }
         Data3D& GetData3D() { return _data3d; }
         Data2D& GetData2D() { return _data2d; }
 
-        bool LoadFont(Font* font, const unsigned char* data, unsigned size);
-        bool LoadFont(Font* font, const std::string& path);
+        /**
+         * @brief Loads font face, ascii glyphs are rasterized up front and the rest on first use. Font must be destroyed before renderer
+         * 
+         */
+        bool LoadFont(Font* font, const unsigned char* data, unsigned size, FontRenderMode mode = FontRenderMode::BITMAP);
+        bool LoadFont(Font* font, const std::string& path, FontRenderMode mode = FontRenderMode::BITMAP);
     private:
-        bool LoadFontWithFace(Font* font, FT_FaceRec_*& face);
+        void Flush2DBatch();
+        // appends sprite quad to 2d batch, flushes when batch is full or out of texture slots
+        void Push2DQuad(unsigned int textureID, const glm::mat4& transform, const glm::vec4& tint, int drawID);
+        void ReadPickIDsAsync(unsigned int attachment, int x, int y, int width, int height, PickRectCallback callback);
+        uint64_t Make3DSortKey(const Model& model, const glm::mat4& transform, const glm::vec4& albedo, Texture* albedoTex, bool instanced);
+        void Flush3DQueue();
+        TextMetrics MeasureText(Font& font, const std::string& text, float scale);
+        void BuildTextLayout(TextLayout& layout, Font& font, const std::string& text, float scale);
+
+        bool LoadFontWithFace(Font* font, FT_FaceRec_*& face, FontRenderMode mode);
 
         Window _window{};
 
         Texture _whiteTexture;
 
+        TextureLoader _textureLoader;
+        uint64_t _textureUploadBudget = 4 * 1024 * 1024;
+        TextureCache _textureCache{ _textureLoader, _whiteTexture };
+        uint64_t _frameIndex = 0;
+
+        PickReader _pickReader;
+        RenderTargetPool _renderTargets;
+        RenderGraph _renderGraph{ _renderTargets };
+        PickMode _pickMode2D = PickMode::GPU;
+        SpritePicker _spritePicker;
+
         DataFullscreen _fullscreen;
 
         Data3D _data3d;
         Data2D _data2d;
 
-        VertexArray _GlyphVAO{};
-        Buffer _GlyphVBO{};
+        // reused between text layout builds to avoid allocating
+        struct GlyphQuad
+        {
+            int page;
+            glm::vec4 rect; // x0, y0, x1, y1
+            glm::vec4 uv;   // u0, v0, u1, v1
+        };
+        std::vector<GlyphQuad> _GlyphQuads;
+        std::vector<glm::vec4> _GlyphVertices;
+
+        struct TextLayoutEntry
+        {
+            uint64_t key;
+            std::shared_ptr<TextLayout> layout;
+        };
+        std::list<TextLayoutEntry> _TextLayoutLRU; // most recently used first
+        std::unordered_map<uint64_t, std::list<TextLayoutEntry>::iterator> _TextLayoutCache;
+        size_t _TextLayoutCacheSize = 256;
 
         std::unique_ptr<FT_LibraryRec_*> _Freetype{};
     };
@@ -3,6 +3,7 @@
 #include <sstream>
 #include "glad/glad.h"
 #include "Core/GL/nm_Texture.hpp"
+#include "Core/GL/nm_StateCache.hpp"
 
 namespace nmGfx
 {
@@ -107,6 +108,8 @@ namespace nmGfx
 
         glDeleteShader(_vertexShaderID);
         glDeleteShader(_fragmentShaderID);
+
+        ReflectUniforms();
 #ifdef NMGFX_PRINT_MESSAGES
         printf("Loaded shader with id: %i, path: %s\n", _programID, _shaderName.c_str());
 #endif
@@ -114,7 +117,7 @@ namespace nmGfx
 
     void Shader::Use()
     {
-        glUseProgram(_programID);
+        StateCache::Get().UseProgram(_programID);
     }
 
     Shader::Shader()
@@ -122,122 +125,179 @@ namespace nmGfx
     }
     Shader::~Shader()
     {
+        StateCache::Get().OnProgramDeleted(_programID);
         glDeleteProgram(_programID);
     }
 
 
 
-    // Uniforms (TEMPORARY SOLUTION) // todo add location caching
-    void Shader::UniformFloat(const std::string& name, float value)
+    void Shader::ReflectUniforms()
     {
-        Use();
-        int loc = glGetUniformLocation(_programID, name.c_str());
-        if(loc < 0)
+        _uniforms.clear();
+
+        int uniformCount = 0;
+        int maxNameLength = 0;
+        glGetProgramiv(_programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+        glGetProgramiv(_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::string name(maxNameLength, '\0');
+        for(int i = 0; i < uniformCount; i++)
         {
-#ifdef NMGFX_PRINT_MESSAGES
-            printf("Failed to get uniform location: %s, Program ID: %i\n", name.c_str(), _programID);
-#endif
-            return;
+            int length = 0;
+            int count = 0;
+            GLenum type = GL_NONE;
+            glGetActiveUniform(_programID, i, maxNameLength, &length, &count, &type, &name[0]);
+
+            std::string uniformName = name.substr(0, length);
+            int loc = glGetUniformLocation(_programID, uniformName.c_str());
+            if(loc < 0) // uniform block members
+                continue;
+
+            _uniforms[uniformName] = Uniform{ loc, type, count };
+
+            // arrays are reported as 'name[0]', register base name and every element
+            size_t bracket = uniformName.find('[');
+            if(bracket != std::string::npos)
+            {
+                std::string baseName = uniformName.substr(0, bracket);
+                _uniforms[baseName] = Uniform{ loc, type, count };
+                for(int e = 1; e < count; e++)
+                {
+                    std::string elementName = baseName + "[" + std::to_string(e) + "]";
+                    int elementLoc = glGetUniformLocation(_programID, elementName.c_str());
+                    if(elementLoc >= 0)
+                        _uniforms[elementName] = Uniform{ elementLoc, type, 1 };
+                }
+            }
         }
-        glUniform1f(loc, value);
     }
 
-    void Shader::UniformVec2(const std::string& name, glm::vec2 value)
+    UniformHandle Shader::GetUniform(const std::string& name) const
     {
-        Use();
-        int loc = glGetUniformLocation(_programID, name.c_str());
-        if(loc < 0)
+        auto it = _uniforms.find(name);
+        if(it == _uniforms.end())
         {
 #ifdef NMGFX_PRINT_MESSAGES
             printf("Failed to get uniform location: %s, Program ID: %i\n", name.c_str(), _programID);
 #endif
-            return;
+            return UniformHandle{};
         }
-        glUniform2f(loc, value.x, value.y);
+        return UniformHandle{ it->second.location };
     }
-    void Shader::UniformVec3(const std::string& name, glm::vec3 value)
+
+
+    // Uniforms
+    void Shader::UniformFloat(UniformHandle handle, float value)
     {
-        Use();
-        int loc = glGetUniformLocation(_programID, name.c_str());
-        if(loc < 0)
-        {
-#ifdef NMGFX_PRINT_MESSAGES
-            printf("Failed to get uniform location: %s, Program ID: %i\n", name.c_str(), _programID);
-#endif
+        if(!handle.IsValid())
             return;
-        }
-        glUniform3f(loc, value.x, value.y, value.z);
+        Use();
+        glUniform1f(handle.location, value);
     }
-    void Shader::UniformVec4(const std::string& name, glm::vec4 value)
+    void Shader::UniformVec2(UniformHandle handle, glm::vec2 value)
     {
+        if(!handle.IsValid())
+            return;
         Use();
-        int loc = glGetUniformLocation(_programID, name.c_str());
-        if(loc < 0)
-        {
-#ifdef NMGFX_PRINT_MESSAGES
-            printf("Failed to get uniform location: %s, Program ID: %i\n", name.c_str(), _programID);
-#endif
+        glUniform2f(handle.location, value.x, value.y);
+    }
+    void Shader::UniformVec3(UniformHandle handle, glm::vec3 value)
+    {
+        if(!handle.IsValid())
             return;
-        }
-        glUniform4f(loc, value.x, value.y, value.z, value.w);
+        Use();
+        glUniform3f(handle.location, value.x, value.y, value.z);
     }
-
-    void Shader::UniformMat4(const std::string& name, glm::mat4 value)
+    void Shader::UniformVec4(UniformHandle handle, glm::vec4 value)
     {
+        if(!handle.IsValid())
+            return;
         Use();
-        int loc = glGetUniformLocation(_programID, name.c_str());
-        if(loc < 0)
-        {
-#ifdef NMGFX_PRINT_MESSAGES
-            printf("Failed to get uniform location: %s, Program ID: %i\n", name.c_str(), _programID);
-#endif
+        glUniform4f(handle.location, value.x, value.y, value.z, value.w);
+    }
+    void Shader::UniformMat4(UniformHandle handle, glm::mat4 value)
+    {
+        if(!handle.IsValid())
             return;
-        }
-        glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]);
+        Use();
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, &value[0][0]);
     }
-
-    void Shader::UniformInt(const std::string& name, int value)
+    void Shader::UniformInt(UniformHandle handle, int value)
     {
+        if(!handle.IsValid())
+            return;
         Use();
-        int loc = glGetUniformLocation(_programID, name.c_str());
-        if(loc < 0)
-        {
-#ifdef NMGFX_PRINT_MESSAGES
-            printf("Failed to get uniform location: %s, Program ID: %i\n", name.c_str(), _programID);
-#endif
+        glUniform1i(handle.location, value);
+    }
+    void Shader::UniformIntArray(UniformHandle handle, const int* values, int count)
+    {
+        if(!handle.IsValid())
             return;
-        }
-        glUniform1i(loc, value);
+        Use();
+        glUniform1iv(handle.location, count, values);
     }
-
-    void Shader::UniformTexture(const std::string& name, Texture& texture, int slot)
+    void Shader::UniformFloatArray(UniformHandle handle, const float* values, int count)
     {
+        if(!handle.IsValid())
+            return;
         Use();
-        int loc = glGetUniformLocation(_programID, name.c_str());
-        if(loc < 0)
-        {
-#ifdef NMGFX_PRINT_MESSAGES
-            printf("Failed to get uniform location: %s, Program ID: %i\n", name.c_str(), _programID);
-#endif
+        glUniform1fv(handle.location, count, values);
+    }
+    void Shader::UniformTexture(UniformHandle handle, Texture& texture, int slot)
+    {
+        if(!handle.IsValid())
             return;
-        }
+        Use();
         texture.Use(slot);
-        glUniform1i(loc, slot);
+        glUniform1i(handle.location, slot);
+    }
+    void Shader::UniformTexture(UniformHandle handle, unsigned int textureID, int slot)
+    {
+        if(!handle.IsValid())
+            return;
+        Use();
+        StateCache::Get().BindTexture(GL_TEXTURE_2D, textureID, slot);
+        glUniform1i(handle.location, slot);
     }
 
+    void Shader::UniformFloat(const std::string& name, float value)
+    {
+        UniformFloat(GetUniform(name), value);
+    }
+    void Shader::UniformVec2(const std::string& name, glm::vec2 value)
+    {
+        UniformVec2(GetUniform(name), value);
+    }
+    void Shader::UniformVec3(const std::string& name, glm::vec3 value)
+    {
+        UniformVec3(GetUniform(name), value);
+    }
+    void Shader::UniformVec4(const std::string& name, glm::vec4 value)
+    {
+        UniformVec4(GetUniform(name), value);
+    }
+    void Shader::UniformMat4(const std::string& name, glm::mat4 value)
+    {
+        UniformMat4(GetUniform(name), value);
+    }
+    void Shader::UniformInt(const std::string& name, int value)
+    {
+        UniformInt(GetUniform(name), value);
+    }
+    void Shader::UniformIntArray(const std::string& name, const int* values, int count)
+    {
+        UniformIntArray(GetUniform(name), values, count);
+    }
+    void Shader::UniformFloatArray(const std::string& name, const float* values, int count)
+    {
+        UniformFloatArray(GetUniform(name), values, count);
+    }
+    void Shader::UniformTexture(const std::string& name, Texture& texture, int slot)
+    {
+        UniformTexture(GetUniform(name), texture, slot);
+    }
     void Shader::UniformTexture(const std::string& name, unsigned int textureID, int slot)
     {
-        Use();
-        int loc = glGetUniformLocation(_programID, name.c_str());
-        if(loc < 0)
-        {
-#ifdef NMGFX_PRINT_MESSAGES
-            printf("Failed to get uniform location: %s, Program ID: %i\n", name.c_str(), _programID);
-#endif
-            return;
-        }
-        glActiveTexture(GL_TEXTURE0+slot);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glUniform1i(loc, slot);
+        UniformTexture(GetUniform(name), textureID, slot);
     }
 } // namespace nmGfx
@@ -3,12 +3,24 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include "glm/glm.hpp"
 
 namespace nmGfx
 {
     class Texture;
 
+    /**
+     * @brief Resolved uniform location. Get it once with Shader::GetUniform and reuse it for every draw
+     * 
+     */
+    struct UniformHandle
+    {
+        int location = -1;
+
+        inline bool IsValid() const { return location >= 0; }
+    };
+
     class Shader
     {
     public:
@@ -17,19 +29,41 @@ namespace nmGfx
         void LoadText(const std::string& text);
         void Use();
 
-        
+        /**
+         * @brief Returns handle of given uniform from the table reflected after link. Invalid handle if uniform is not active
+         * 
+         * @param name 
+         * @return UniformHandle 
+         */
+        UniformHandle GetUniform(const std::string& name) const;
+
+        void UniformFloat(UniformHandle handle, float value);
+        void UniformVec2(UniformHandle handle, glm::vec2 value);
+        void UniformVec3(UniformHandle handle, glm::vec3 value);
+        void UniformVec4(UniformHandle handle, glm::vec4 value);
+        void UniformMat4(UniformHandle handle, glm::mat4 value);
+        void UniformInt(UniformHandle handle, int value);
+        void UniformIntArray(UniformHandle handle, const int* values, int count);
+        void UniformFloatArray(UniformHandle handle, const float* values, int count);
+        void UniformTexture(UniformHandle handle, Texture& texture, int slot);
+        void UniformTexture(UniformHandle handle, unsigned int textureID, int slot);
+
         void UniformFloat(const std::string& name, float value);
         void UniformVec2(const std::string& name, glm::vec2 value);
         void UniformVec3(const std::string& name, glm::vec3 value);
         void UniformVec4(const std::string& name, glm::vec4 value);
         void UniformMat4(const std::string& name, glm::mat4 value);
         void UniformInt(const std::string& name, int value);
+        void UniformIntArray(const std::string& name, const int* values, int count);
+        void UniformFloatArray(const std::string& name, const float* values, int count);
         void UniformTexture(const std::string& name, Texture& texture, int slot);
         void UniformTexture(const std::string& name, unsigned int textureID, int slot);
 
         Shader();
         ~Shader();
     private:
+        void ReflectUniforms();
+
         std::string _shaderName{""};
 
         std::string _vertexSource{""};
@@ -39,6 +73,14 @@ namespace nmGfx
         unsigned int _fragmentShaderID = 0;
         unsigned int _programID = 0;
 
+        struct Uniform
+        {
+            int location;
+            unsigned int type;
+            int count;
+        };
+        std::unordered_map<std::string, Uniform> _uniforms;
+
         friend class Renderer;
     };
 } // namespace nmGfx
@@ -0,0 +1,162 @@
+#include "nm_SpritePicker.hpp"
+#include <algorithm>
+
+namespace nmGfx
+{
+    static inline float Cross(const glm::vec2& a, const glm::vec2& b)
+    {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    void SpritePicker::Begin(int width, int height, int cellSize /*= 64*/)
+    {
+        _quads.clear();
+        _cellSize = cellSize > 0 ? cellSize : 64;
+
+        int cellsX = (width + _cellSize - 1) / _cellSize;
+        int cellsY = (height + _cellSize - 1) / _cellSize;
+        cellsX = cellsX > 0 ? cellsX : 1;
+        cellsY = cellsY > 0 ? cellsY : 1;
+
+        // cells keep their capacity between frames
+        if(cellsX != _cellsX || cellsY != _cellsY)
+        {
+            _cellsX = cellsX;
+            _cellsY = cellsY;
+            _cells.assign((size_t)_cellsX * _cellsY, std::vector<uint32_t>());
+        }
+        else
+        {
+            for(std::vector<uint32_t>& cell : _cells)
+                cell.clear();
+        }
+    }
+
+    void SpritePicker::Insert(const glm::vec3 corners[4], int drawID)
+    {
+        Quad quad;
+        quad.min = glm::vec2(corners[0]);
+        quad.max = glm::vec2(corners[0]);
+        quad.depth = 0.f;
+        float area = 0.f;
+        for(int i = 0; i < 4; i++)
+        {
+            quad.corners[i] = glm::vec2(corners[i]);
+            quad.min = glm::min(quad.min, quad.corners[i]);
+            quad.max = glm::max(quad.max, quad.corners[i]);
+            quad.depth += corners[i].z * 0.25f;
+            area += Cross(glm::vec2(corners[i]), glm::vec2(corners[(i + 1) & 3]));
+        }
+        quad.drawID = drawID;
+
+        // degenerate quads don't cover any pixel
+        if(area == 0.f)
+            return;
+        // store counter clockwise so containment tests only need one sign
+        if(area < 0.f)
+            std::swap(quad.corners[1], quad.corners[3]);
+
+        int x0 = (int)(quad.min.x / _cellSize);
+        int y0 = (int)(quad.min.y / _cellSize);
+        int x1 = (int)(quad.max.x / _cellSize);
+        int y1 = (int)(quad.max.y / _cellSize);
+        if(quad.max.x < 0.f || quad.max.y < 0.f || x0 >= _cellsX || y0 >= _cellsY)
+            return;
+
+        x0 = x0 > 0 ? x0 : 0;
+        y0 = y0 > 0 ? y0 : 0;
+        x1 = x1 < _cellsX - 1 ? x1 : _cellsX - 1;
+        y1 = y1 < _cellsY - 1 ? y1 : _cellsY - 1;
+
+        uint32_t index = _quads.size();
+        _quads.push_back(quad);
+        for(int y = y0; y <= y1; y++)
+            for(int x = x0; x <= x1; x++)
+                _cells[(size_t)y * _cellsX + x].push_back(index);
+    }
+
+    bool SpritePicker::ContainsPoint(const Quad& quad, const glm::vec2& point)
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            const glm::vec2& a = quad.corners[i];
+            const glm::vec2& b = quad.corners[(i + 1) & 3];
+            if(Cross(b - a, point - a) < 0.f)
+                return false;
+        }
+        return true;
+    }
+
+    bool SpritePicker::OverlapsRect(const Quad& quad, const glm::vec2& min, const glm::vec2& max)
+    {
+        if(quad.max.x < min.x || quad.min.x > max.x || quad.max.y < min.y || quad.min.y > max.y)
+            return false;
+
+        // bounds cover the rectangle's axes, quad edges are the remaining separating axes
+        glm::vec2 rect[4] = { min, { max.x, min.y }, max, { min.x, max.y } };
+        for(int i = 0; i < 4; i++)
+        {
+            const glm::vec2& a = quad.corners[i];
+            const glm::vec2& b = quad.corners[(i + 1) & 3];
+            bool separated = true;
+            for(int c = 0; c < 4 && separated; c++)
+                separated = Cross(b - a, rect[c] - a) < 0.f;
+            if(separated)
+                return false;
+        }
+        return true;
+    }
+
+    int SpritePicker::Pick(int x, int y) const
+    {
+        if(x < 0 || y < 0 || _cellsX == 0)
+            return 0;
+
+        int cellX = x / _cellSize;
+        int cellY = y / _cellSize;
+        if(cellX >= _cellsX || cellY >= _cellsY)
+            return 0;
+
+        // same point gpu samples the pixel at
+        glm::vec2 point((float)x + 0.5f, (float)y + 0.5f);
+        const Quad* best = nullptr;
+        for(uint32_t index : _cells[(size_t)cellY * _cellsX + cellX])
+        {
+            const Quad& quad = _quads[index];
+            if((best == nullptr || quad.depth < best->depth) && ContainsPoint(quad, point))
+                best = &quad;
+        }
+        return best != nullptr ? best->drawID : 0;
+    }
+
+    void SpritePicker::PickRect(int x, int y, int width, int height, std::vector<int>& ids) const
+    {
+        ids.clear();
+        if(width <= 0 || height <= 0 || _cellsX == 0)
+            return;
+
+        glm::vec2 min((float)x, (float)y);
+        glm::vec2 max((float)(x + width), (float)(y + height));
+
+        int x0 = std::max(x / _cellSize, 0);
+        int y0 = std::max(y / _cellSize, 0);
+        int x1 = std::min((x + width - 1) / _cellSize, _cellsX - 1);
+        int y1 = std::min((y + height - 1) / _cellSize, _cellsY - 1);
+
+        for(int cy = y0; cy <= y1; cy++)
+        {
+            for(int cx = x0; cx <= x1; cx++)
+            {
+                for(uint32_t index : _cells[(size_t)cy * _cellsX + cx])
+                {
+                    const Quad& quad = _quads[index];
+                    if(quad.drawID != 0 && OverlapsRect(quad, min, max))
+                        ids.push_back(quad.drawID);
+                }
+            }
+        }
+
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+} // namespace nmGfx
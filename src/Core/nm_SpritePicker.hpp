@@ -0,0 +1,80 @@
+#ifndef __NM_GFX_SPRITE_PICKER_HPP__
+#define __NM_GFX_SPRITE_PICKER_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace nmGfx
+{
+    // Where 2d pick ids come from
+    enum class PickMode
+    {
+        GPU = 0, // draw ids are rendered into an integer attachment and read back
+        CPU,     // sprites are kept in a SpritePicker, no draw id attachment is needed
+    };
+
+    /**
+     * @brief Uniform grid of sprite quads in framebuffer pixels, answers pick queries without gpu
+     *
+     * Quads are picked by their shape, transparent texels of textures count as hits.
+     * Overlapping quads resolve like the depth test: lower depth wins, on equal depth the earlier one.
+     */
+    class SpritePicker
+    {
+        public:
+            /**
+             * @brief Clears quads and sizes grid to the framebuffer
+             *
+             * @param width framebuffer width in pixels
+             * @param height framebuffer height in pixels
+             * @param cellSize grid cell size in pixels
+             */
+            void Begin(int width, int height, int cellSize = 64);
+
+            /**
+             * @brief Adds convex quad
+             *
+             * @param corners x, y in framebuffer pixels from bottom left and depth in z, in winding order
+             * @param drawID
+             */
+            void Insert(const glm::vec3 corners[4], int drawID);
+
+            /**
+             * @brief Returns id of topmost quad covering pixel x, y. 0 if there is none
+             *
+             */
+            int Pick(int x, int y) const;
+            /**
+             * @brief Collects unique non zero ids of quads touching rectangle, sorted. Covered quads are included
+             *
+             */
+            void PickRect(int x, int y, int width, int height, std::vector<int>& ids) const;
+
+            inline size_t GetCount() const { return _quads.size(); }
+
+        private:
+            struct Quad
+            {
+                glm::vec2 corners[4];
+                glm::vec2 min;
+                glm::vec2 max;
+                float depth;
+                int drawID;
+            };
+
+            static bool ContainsPoint(const Quad& quad, const glm::vec2& point);
+            static bool OverlapsRect(const Quad& quad, const glm::vec2& min, const glm::vec2& max);
+
+            std::vector<Quad> _quads;
+            std::vector<std::vector<uint32_t>> _cells; // quad indices, in insertion order
+            int _cellSize = 64;
+            int _cellsX = 0;
+            int _cellsY = 0;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_SPRITE_PICKER_HPP__
@@ -0,0 +1,75 @@
+#include "nm_ThreadPool.hpp"
+
+namespace nmGfx
+{
+    ThreadPool::ThreadPool(uint32_t threadCount)
+    {
+        if(threadCount == 0)
+            threadCount = std::thread::hardware_concurrency();
+        if(threadCount == 0)
+            threadCount = 1;
+
+        _workers.reserve(threadCount);
+        for(uint32_t i = 0; i < threadCount; i++)
+            _workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _condition.notify_all();
+
+        for(std::thread& worker : _workers)
+            worker.join();
+    }
+
+    std::future<void> ThreadPool::Submit(std::function<void()> task)
+    {
+        std::packaged_task<void()> packaged(std::move(task));
+        std::future<void> future = packaged.get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push_back(std::move(packaged));
+        }
+        _condition.notify_one();
+        return future;
+    }
+
+    bool ThreadPool::IsWorkerThread() const
+    {
+        std::thread::id id = std::this_thread::get_id();
+        for(const std::thread& worker : _workers)
+        {
+            if(worker.get_id() == id)
+                return true;
+        }
+        return false;
+    }
+
+    ThreadPool& ThreadPool::Shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while(true)
+        {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+                if(_tasks.empty())
+                    return;
+
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            task();
+        }
+    }
+} // namespace nmGfx
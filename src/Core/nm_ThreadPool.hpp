@@ -0,0 +1,65 @@
+#ifndef __NM_GFX_THREAD_POOL_HPP__
+#define __NM_GFX_THREAD_POOL_HPP__
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+namespace nmGfx
+{
+    /**
+     * @brief Fixed number of worker threads running submitted tasks in fifo order
+     *
+     * Destructor finishes queued tasks before joining.
+     */
+    class ThreadPool
+    {
+        public:
+            /**
+             * @brief
+             *
+             * @param threadCount 0 uses hardware concurrency
+             */
+            ThreadPool(uint32_t threadCount = 0);
+            ~ThreadPool();
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /**
+             * @brief Queues task, returned future becomes ready when it finishes
+             *
+             * @param task
+             * @return std::future<void>
+             */
+            std::future<void> Submit(std::function<void()> task);
+
+            inline uint32_t GetThreadCount() const { return (uint32_t)_workers.size(); }
+            // True when called from a task of this pool, waiting on other tasks there can deadlock
+            bool IsWorkerThread() const;
+
+            /**
+             * @brief Pool shared by loaders, created on first use
+             *
+             * @return ThreadPool&
+             */
+            static ThreadPool& Shared();
+
+        private:
+            void WorkerLoop();
+
+            std::vector<std::thread> _workers;
+            std::deque<std::packaged_task<void()>> _tasks;
+            std::mutex _mutex;
+            std::condition_variable _condition;
+            bool _stopping = false;
+    };
+} // namespace nmGfx
+
+
+#endif // __NM_GFX_THREAD_POOL_HPP__
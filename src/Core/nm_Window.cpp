@@ -3,6 +3,7 @@
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
+#include "Core/GL/nm_StateCache.hpp"
 
 namespace nmGfx
 {
@@ -36,7 +37,7 @@ static void error_callback(int error, const char* description)
 
 static void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    nmGfx::StateCache::Get().Viewport(0, 0, width, height);
 }
 
 namespace nmGfx
@@ -162,8 +163,8 @@ namespace nmGfx
 
     void Window::UnbindFramebuffer()
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glViewport(0, 0, GetWindowWidth(), GetWindowHeight());
+        StateCache::Get().BindFramebuffer(0);
+        StateCache::Get().Viewport(0, 0, GetWindowWidth(), GetWindowHeight());
     }
 
 
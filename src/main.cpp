@@ -37,6 +37,7 @@ int main(int argc, char const *argv[])
     renderer.GetData3D()._shader.LoadFile("res/default.glsl");
     renderer.GetData3D()._skyboxShader.LoadFile("res/skybox.glsl");
     renderer.GetDataFullscreen()._shader.LoadFile("res/fullscreen.glsl");
+    renderer.GetDataFullscreen()._compositeShader.LoadFile("res/composite.glsl");
 
     nmGfx::Shader textShader;
     textShader.LoadFile("res/text.glsl");
@@ -52,8 +53,8 @@ int main(int argc, char const *argv[])
     std::shared_ptr<nmGfx::Texture> tex = std::make_shared<nmGfx::Texture>();
     tex->Load2DFromFile("res/viking_room.png");
 
-    std::shared_ptr<nmGfx::Texture> tex2d = std::make_shared<nmGfx::Texture>();
-    tex2d->Load2DFromFile("res/image.jpeg");
+    // drawn white until decoded and uploaded
+    std::shared_ptr<nmGfx::Texture> tex2d = renderer.LoadTextureAsync("res/image.jpeg");
 
     nmGfx::Font font;
     if(!renderer.LoadFont(&font, "res/Roboto-Medium.ttf")) {
@@ -63,7 +64,7 @@ int main(int argc, char const *argv[])
     nmGfx::Framebuffer mainPass;
     mainPass.Create2DDefault(&window, 1920, 1080);
 
-    glEnable(GL_BLEND);
+    renderer.SetBlending(true);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     nmGfx::Material mat;
@@ -108,9 +109,10 @@ int main(int argc, char const *argv[])
         t += 0.01f;
 
         renderer.ClearLayers();
-        // renderer.Draw3DLayer();
-        renderer.Draw2DLayer();
-        renderer.DrawPassLayer(mainPass);
+        // renderer.Add3DLayer();
+        renderer.Add2DLayer();
+        renderer.AddPassLayer(mainPass);
+        renderer.CompositeLayers();
 
         window.SwapBuffers();
     }
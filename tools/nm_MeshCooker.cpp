@@ -0,0 +1,49 @@
+// Converts obj files to binary mesh files Model::LoadFromFile picks up when loading with the same settings
+// usage: nmMeshCooker [--overdraw] [--compact|--half] input.obj [output.nmesh]
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+#include "Core/GL/nm_MeshFile.hpp"
+
+int main(int argc, char const *argv[])
+{
+    nmGfx::MeshOptimizeSettings optimize;
+    nmGfx::VertexQuantization quantization = nmGfx::VertexQuantization::NONE;
+    const char* input = nullptr;
+    const char* output = nullptr;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--overdraw") == 0)
+            optimize.overdraw = true;
+        else if(strcmp(argv[i], "--compact") == 0)
+            quantization = nmGfx::VertexQuantization::COMPACT;
+        else if(strcmp(argv[i], "--half") == 0)
+            quantization = nmGfx::VertexQuantization::HALF;
+        else if(input == nullptr)
+            input = argv[i];
+        else if(output == nullptr)
+            output = argv[i];
+    }
+
+    if(input == nullptr)
+    {
+        printf("usage: %s [--overdraw] [--compact|--half] input.obj [output.nmesh]\n", argv[0]);
+        return 1;
+    }
+
+    std::string outputPath = output != nullptr ? output : nmGfx::MeshFile::GetCachePath(input);
+    if(!nmGfx::MeshFile::Cook(input, outputPath.c_str(), optimize, quantization))
+    {
+        printf("Failed to cook %s\n", input);
+        return 1;
+    }
+
+    printf("Cooked %s -> %s\n", input, outputPath.c_str());
+    return 0;
+}
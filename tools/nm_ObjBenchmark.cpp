@@ -0,0 +1,51 @@
+// Compares parallel obj parser against tinyobj on the same file
+// usage: nmObjBenchmark input.obj [threads]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+#include "Core/GL/nm_Model.hpp"
+#include "Core/nm_ObjParser.hpp"
+
+int main(int argc, char const *argv[])
+{
+    if(argc < 2)
+    {
+        printf("usage: %s input.obj [threads]\n", argv[0]);
+        return 1;
+    }
+    const char* path = argv[1];
+    uint32_t threads = argc > 2 ? (uint32_t)atoi(argv[2]) : 0;
+
+    std::vector<float> tinyVertices, parallelVertices;
+    std::vector<uint32_t> tinyIndices, parallelIndices;
+
+    auto start = std::chrono::steady_clock::now();
+    bool tinyLoaded = nmGfx::LoadObjMesh(path, tinyVertices, tinyIndices);
+    auto tinyEnd = std::chrono::steady_clock::now();
+
+    nmGfx::ThreadPool pool(threads);
+    auto parallelStart = std::chrono::steady_clock::now();
+    bool parallelLoaded = nmGfx::ParseObjParallel(path, parallelVertices, parallelIndices, pool);
+    auto parallelEnd = std::chrono::steady_clock::now();
+
+    double tinyMs = std::chrono::duration<double, std::milli>(tinyEnd - start).count();
+    double parallelMs = std::chrono::duration<double, std::milli>(parallelEnd - parallelStart).count();
+
+    printf("tinyobj:  %s, %8.2f ms, %zu vertices, %zu indices\n", tinyLoaded ? "ok" : "failed", tinyMs, tinyVertices.size() / 8, tinyIndices.size());
+    printf("parallel: %s, %8.2f ms, %zu vertices, %zu indices, %u threads\n", parallelLoaded ? "ok" : "failed", parallelMs, parallelVertices.size() / 8, parallelIndices.size(), pool.GetThreadCount());
+    if(parallelMs > 0.0)
+        printf("speedup:  %.2fx\n", tinyMs / parallelMs);
+
+    bool same = tinyIndices == parallelIndices && tinyVertices.size() == parallelVertices.size();
+    for(size_t i = 0; same && i < tinyVertices.size(); i++)
+        same = fabsf(tinyVertices[i] - parallelVertices[i]) <= 1e-5f * fmaxf(1.f, fabsf(tinyVertices[i]));
+    printf("output:   %s\n", same ? "identical" : "DIFFERENT");
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Encodes png/jpeg/etc. into block compressed DDS files with mips for Texture::LoadCompressedFromFile
+// usage: nmTextureEncoder [--bc1|--bc3|--bc5|--bc7] [--no-mips] input.png [output.dds]
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "Core/nm_CompressedImage.hpp"
+
+// 2x2 box filter, odd edges reuse last row or column
+static void Downsample(const std::vector<uint8_t>& source, uint32_t width, uint32_t height, std::vector<uint8_t>& target, uint32_t& targetWidth, uint32_t& targetHeight)
+{
+    targetWidth = width > 1 ? width / 2 : 1;
+    targetHeight = height > 1 ? height / 2 : 1;
+    target.resize((size_t)targetWidth * targetHeight * 4);
+
+    for(uint32_t y = 0; y < targetHeight; y++)
+    {
+        uint32_t y0 = y * 2 < height ? y * 2 : height - 1;
+        uint32_t y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+        for(uint32_t x = 0; x < targetWidth; x++)
+        {
+            uint32_t x0 = x * 2 < width ? x * 2 : width - 1;
+            uint32_t x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                uint32_t sum = source[((size_t)y0 * width + x0) * 4 + c] + source[((size_t)y0 * width + x1) * 4 + c]
+                             + source[((size_t)y1 * width + x0) * 4 + c] + source[((size_t)y1 * width + x1) * 4 + c];
+                target[((size_t)y * targetWidth + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    nmGfx::BlockFormat format = nmGfx::BlockFormat::BC7;
+    bool mips = true;
+    const char* input = nullptr;
+    const char* output = nullptr;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--bc1") == 0)
+            format = nmGfx::BlockFormat::BC1;
+        else if(strcmp(argv[i], "--bc3") == 0)
+            format = nmGfx::BlockFormat::BC3;
+        else if(strcmp(argv[i], "--bc5") == 0)
+            format = nmGfx::BlockFormat::BC5;
+        else if(strcmp(argv[i], "--bc7") == 0)
+            format = nmGfx::BlockFormat::BC7;
+        else if(strcmp(argv[i], "--no-mips") == 0)
+            mips = false;
+        else if(input == nullptr)
+            input = argv[i];
+        else if(output == nullptr)
+            output = argv[i];
+    }
+
+    if(input == nullptr)
+    {
+        printf("usage: %s [--bc1|--bc3|--bc5|--bc7] [--no-mips] input.png [output.dds]\n", argv[0]);
+        return 1;
+    }
+
+    // flipped like Texture::Load2DFromFile, so compressed textures use same uvs
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* pixels = stbi_load(input, &width, &height, &channels, 4);
+    if(pixels == nullptr)
+    {
+        printf("Failed to load %s\n", input);
+        return 1;
+    }
+
+    uint32_t levelWidth = width;
+    uint32_t levelHeight = height;
+    std::vector<uint8_t> image(pixels, pixels + (size_t)width * height * 4);
+    stbi_image_free(pixels);
+
+    std::vector<std::vector<uint8_t>> levels;
+    while(true)
+    {
+        levels.emplace_back();
+        nmGfx::EncodeImage(format, image.data(), levelWidth, levelHeight, levels.back());
+
+        if(!mips || (levelWidth == 1 && levelHeight == 1))
+            break;
+
+        std::vector<uint8_t> next;
+        Downsample(image, levelWidth, levelHeight, next, levelWidth, levelHeight);
+        image.swap(next);
+    }
+
+    std::string outputPath = output != nullptr ? output : std::string(input) + ".dds";
+    if(!nmGfx::CompressedImage::WriteDDS(outputPath.c_str(), format, width, height, levels))
+    {
+        printf("Failed to write %s\n", outputPath.c_str());
+        return 1;
+    }
+
+    printf("Encoded %s -> %s (%d levels)\n", input, outputPath.c_str(), (int)levels.size());
+    return 0;
+}